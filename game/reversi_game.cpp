@@ -1,24 +1,66 @@
 // Copyright 2016 iRonhead
+#include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include "../reversi/board.hpp"
+#include "../reversi/book.hpp"
 #include "../reversi/reversi.hpp"
 #include "../uct/uct.hpp"
 
 using std::cin;
 using std::cout;
+using std::atoi;
 using std::endl;
 using std::shared_ptr;
 using std::string;
 
-int main() {
-  UpperConfidenceTree uct(10000);
+// Book moves searched less are left to the search.
+static const uint32_t kBookMinVisits = 1000;
+
+// ./a.out [milliseconds]
+//
+// With milliseconds, the computer thinks that long for each move, else it
+// plays 10000 rounds per move. The openings are played from reversi.book if
+// there is one, see make book.
+int main(int argc, char** argv) {
+  UctOptions options;
+
+  // Keep the visits of the replies searched for the last move.
+  options.reuse_tree = true;
+
+  // Share the statistics of transpositions.
+  options.transposition_table_size = 64 << 20;
+
+  // Play perfectly once 16 squares are left, a solve takes ~0.1s then.
+  options.solve_depth = 16;
+
+  // Stop searching what is already known.
+  options.prove = true;
+
+  if (argc > 1) {
+    options.count_round = 0;
+    options.time_limit = atoi(argv[1]);
+
+    if (options.time_limit <= 0) {
+      cout << "usage: " << argv[0] << " [milliseconds per move]" << endl;
+
+      return 1;
+    }
+  }
+
+  Uct<ReversiGame> uct(options);
+
+  OpeningBook book;
+
+  if (book.Open("reversi.book")) {
+    cout << "opening book: " << book.CountEntries() << " moves" << endl;
+  }
 
   string command;
 
   ReversiState* game_state = new ReversiState();
-  ReversiState* temp_state = nullptr;
 
   game_state->Inspect();
 
@@ -31,8 +73,13 @@ int main() {
       if (moves.empty()) {
         game_state->MoveAt(-1, -1);
       } else {
+        // Think about the replies while the player does.
+        uct.StartPonder(game_state->ToBoard());
+
         cin >> command;
 
+        uct.StopPonder();
+
         if ((command.length() != 2) ||
             (command[0] < '0' || command[0] > '9') ||
             (command[1] < 'A' || command[1] > 'H')) {
@@ -53,11 +100,36 @@ int main() {
     } else {
       cout << "(~_~)...thinking..." << endl;
 
-      temp_state = dynamic_cast<ReversiState*>(uct.Search(game_state));
+      ReversiBoard move;
 
-      delete game_state;
+      if (book.Probe(game_state->ToBoard(), kBookMinVisits, &move)) {
+        *game_state = ReversiState(move);
 
-      game_state = temp_state;
+        cout << "book move" << endl;
+      } else {
+        *game_state = ReversiState(uct.Search(game_state->ToBoard()));
+
+        const auto& report = uct.GetReport();
+
+        if (!report.is_solved) {
+          cout << report.count_round << " rounds in " << report.milliseconds
+               << " ms, " << report.count_reused_visits << " visits reused"
+               << endl;
+        } else if (report.score != 0) {
+          cout << "solved in " << report.milliseconds << " ms, the computer "
+               << (report.score > 0 ? "wins" : "loses") << " by "
+               << (report.score > 0 ? report.score : -report.score) << endl;
+        } else {
+          cout << "solved in " << report.milliseconds << " ms, a draw"
+               << endl;
+        }
+
+        const auto& ponder = uct.GetPonderStats();
+
+        cout << "ponder hits: " << ponder.count_hit << ", misses: "
+             << ponder.count_miss << ", rounds: " << ponder.count_round
+             << endl;
+      }
     }
 
     game_state->Inspect();
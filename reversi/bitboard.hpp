@@ -0,0 +1,532 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_BITBOARD_H__
+#define REVERSI_BITBOARD_H__
+
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif  // __AVX2__
+
+// Bit i of a board is the square (x, y) = (i % 8, i / 8), the same layout as
+// ReversiState. Everything here is inline, it sits on the hot path of both
+// the tree search and the random playouts.
+class Bitboard {
+ public:
+  // Squares on column 1 ~ 6. Stones on column 0 / 7 can not be flanked
+  // horizontally or diagonally, masking them out also stops the shifts from
+  // wrapping around the rows.
+  static const uint64_t kInnerColumns = 0x7e7e7e7e7e7e7e7eull;
+
+  // The board has 8 symmetries, the identity included.
+  static const int32_t kCountSymmetries = 8;
+
+  // Boards handled at once by ValidMoves4 and Flips4, one per 64-bit lane of
+  // an AVX2 register.
+  static const int32_t kLanes = 4;
+
+  // Number of stones on the board.
+  static int32_t Count(uint64_t board);
+
+  // Index of the lowest stone, board must not be 0.
+  static int32_t IndexOfLowest(uint64_t board);
+
+  // The n-th (0 based, from the lowest) stone of board as a one bit mask.
+  static uint64_t NthBit(uint64_t board, int32_t n);
+
+  // All squares where the owner of self can legally put a stone, computed with
+  // Kogge-Stone fills in the 8 directions at once.
+  static uint64_t ValidMoves(uint64_t self, uint64_t opponent);
+
+  // Opponent stones flipped when the owner of self puts a stone on move (a one
+  // bit mask of an empty square). Returns 0 if move flips nothing, i.e. it is
+  // not a valid move. Built with -mavx2, the 8 directions are done in 4x64 bit
+  // lanes.
+  static uint64_t Flips(uint64_t self, uint64_t opponent, uint64_t move);
+
+  // ValidMoves and Flips of kLanes unrelated boards, moves[i] and flips[i]
+  // are those of (self[i], opponent[i]). A move of 0 flips nothing. With
+  // AVX2 all lanes go through the same vector instructions, else they are
+  // done one by one, the results are the same.
+  static void ValidMoves4(
+    const uint64_t* self, const uint64_t* opponent, uint64_t* moves);
+  static void Flips4(const uint64_t* self, const uint64_t* opponent,
+                     const uint64_t* moves, uint64_t* flips);
+
+  // (x, y) -> (x, 7 - y).
+  static uint64_t FlipVertical(uint64_t board);
+
+  // (x, y) -> (7 - x, y).
+  static uint64_t MirrorHorizontal(uint64_t board);
+
+  // (x, y) -> (y, x).
+  static uint64_t FlipDiagonal(uint64_t board);
+
+  // (x, y) -> (7 - y, 7 - x).
+  static uint64_t FlipAntiDiagonal(uint64_t board);
+
+  // (x, y) -> (7 - y, x), a quarter turn clockwise.
+  static uint64_t Rotate90(uint64_t board);
+
+  // (x, y) -> (7 - x, 7 - y).
+  static uint64_t Rotate180(uint64_t board);
+
+  // (x, y) -> (y, 7 - x).
+  static uint64_t Rotate270(uint64_t board);
+
+  // Put the 8 symmetric images of board into images, images[0] is board. The
+  // order is the same for every board.
+  static void Symmetries(uint64_t board, uint64_t* images);
+
+  // images[k] of Symmetries, k in [0, kCountSymmetries).
+  static uint64_t Symmetry(uint64_t board, int32_t k);
+
+  // The k of the image Canonicalize picks, the least one if more than one
+  // image is the canonical form.
+  static int32_t CanonicalSymmetry(uint64_t blacks, uint64_t whites);
+
+  // Turn (blacks, whites) into the least of its 8 images, comparing blacks
+  // first. Symmetric positions have the same canonical form.
+  static void Canonicalize(uint64_t* blacks, uint64_t* whites);
+
+ private:
+  // Occluded fill of opponent stones in one direction, starting next to self.
+  static uint64_t FillLeft(uint64_t self, uint64_t opponent, int32_t shift);
+  static uint64_t FillRight(uint64_t self, uint64_t opponent, int32_t shift);
+
+  // Flanked part of a fill, 0 if the fill does not end on a stone of self.
+  static uint64_t Flanked(uint64_t fill, uint64_t end, uint64_t self);
+
+  static uint64_t FlipsScalar(uint64_t self, uint64_t opponent, uint64_t move);
+
+#ifdef __AVX2__
+  static uint64_t FlipsAvx2(uint64_t self, uint64_t opponent, uint64_t move);
+
+  // FillLeft, FillRight and Flanked of 4 boards. The shifts are template
+  // arguments, a shift by an immediate is cheaper than one by a register.
+  template <int32_t kShift>
+  static __m256i FillLeft4(__m256i self, __m256i opponent);
+  template <int32_t kShift>
+  static __m256i FillRight4(__m256i self, __m256i opponent);
+  static __m256i Flanked4(__m256i fill, __m256i end, __m256i self);
+
+  // Moves and flips of one direction pair of 4 boards, opponent is masked
+  // for the directions which wrap around the rows.
+  template <int32_t kShift>
+  static __m256i ValidMovesPair4(__m256i self, __m256i opponent);
+  template <int32_t kShift>
+  static __m256i FlipsPair4(__m256i self, __m256i opponent, __m256i move);
+#endif  // __AVX2__
+};
+
+//------------------------------------------------------------------------------
+inline int32_t Bitboard::Count(uint64_t board) {
+  return __builtin_popcountll(board);
+}
+
+//------------------------------------------------------------------------------
+inline int32_t Bitboard::IndexOfLowest(uint64_t board) {
+  return __builtin_ctzll(board);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::NthBit(uint64_t board, int32_t n) {
+  while (n-- > 0) {
+    board &= board - 1;
+  }
+
+  return board & (~board + 1);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FlipVertical(uint64_t board) {
+  // Rows are bytes.
+  return __builtin_bswap64(board);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::MirrorHorizontal(uint64_t board) {
+  const uint64_t k1 = 0x5555555555555555ull;
+  const uint64_t k2 = 0x3333333333333333ull;
+  const uint64_t k4 = 0x0f0f0f0f0f0f0f0full;
+
+  board = ((board >> 1) & k1) | ((board & k1) << 1);
+  board = ((board >> 2) & k2) | ((board & k2) << 2);
+  board = ((board >> 4) & k4) | ((board & k4) << 4);
+
+  return board;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FlipDiagonal(uint64_t board) {
+  const uint64_t k1 = 0x5500550055005500ull;
+  const uint64_t k2 = 0x3333000033330000ull;
+  const uint64_t k4 = 0x0f0f0f0f00000000ull;
+
+  uint64_t t;
+
+  // Swap 4x4 blocks, then 2x2 blocks, then single squares.
+  t = k4 & (board ^ (board << 28));
+  board ^= t ^ (t >> 28);
+  t = k2 & (board ^ (board << 14));
+  board ^= t ^ (t >> 14);
+  t = k1 & (board ^ (board << 7));
+  board ^= t ^ (t >> 7);
+
+  return board;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FlipAntiDiagonal(uint64_t board) {
+  return Bitboard::Rotate180(Bitboard::FlipDiagonal(board));
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Rotate90(uint64_t board) {
+  return Bitboard::MirrorHorizontal(Bitboard::FlipDiagonal(board));
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Rotate180(uint64_t board) {
+  return Bitboard::FlipVertical(Bitboard::MirrorHorizontal(board));
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Rotate270(uint64_t board) {
+  return Bitboard::FlipVertical(Bitboard::FlipDiagonal(board));
+}
+
+//------------------------------------------------------------------------------
+inline void Bitboard::Symmetries(uint64_t board, uint64_t* images) {
+  const uint64_t diagonal = Bitboard::FlipDiagonal(board);
+
+  images[0] = board;
+  images[1] = Bitboard::FlipVertical(board);
+  images[2] = Bitboard::MirrorHorizontal(board);
+  images[3] = Bitboard::FlipVertical(images[2]);
+  images[4] = diagonal;
+  images[5] = Bitboard::FlipVertical(diagonal);
+  images[6] = Bitboard::MirrorHorizontal(diagonal);
+  images[7] = Bitboard::FlipVertical(images[6]);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Symmetry(uint64_t board, int32_t k) {
+  // Images 4 ~ 7 are images 0 ~ 3 of the diagonal flip.
+  if (k >= 4) { board = Bitboard::FlipDiagonal(board); }
+  if (k & 2) { board = Bitboard::MirrorHorizontal(board); }
+  if (k & 1) { board = Bitboard::FlipVertical(board); }
+
+  return board;
+}
+
+//------------------------------------------------------------------------------
+inline int32_t Bitboard::CanonicalSymmetry(uint64_t blacks, uint64_t whites) {
+  uint64_t images_blacks[Bitboard::kCountSymmetries];
+  uint64_t images_whites[Bitboard::kCountSymmetries];
+
+  Bitboard::Symmetries(blacks, images_blacks);
+  Bitboard::Symmetries(whites, images_whites);
+
+  auto canonical = 0;
+
+  for (auto i = 1; i < Bitboard::kCountSymmetries; ++i) {
+    if (images_blacks[i] < images_blacks[canonical] ||
+        (images_blacks[i] == images_blacks[canonical] &&
+         images_whites[i] < images_whites[canonical])) {
+      canonical = i;
+    }
+  }
+
+  return canonical;
+}
+
+//------------------------------------------------------------------------------
+inline void Bitboard::Canonicalize(uint64_t* blacks, uint64_t* whites) {
+  uint64_t images_blacks[Bitboard::kCountSymmetries];
+  uint64_t images_whites[Bitboard::kCountSymmetries];
+
+  Bitboard::Symmetries(*blacks, images_blacks);
+  Bitboard::Symmetries(*whites, images_whites);
+
+  for (auto i = 1; i < Bitboard::kCountSymmetries; ++i) {
+    if (images_blacks[i] < *blacks ||
+        (images_blacks[i] == *blacks && images_whites[i] < *whites)) {
+      *blacks = images_blacks[i];
+      *whites = images_whites[i];
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FillLeft(
+    uint64_t self, uint64_t opponent, int32_t shift) {
+  uint64_t fill = opponent & (self << shift);
+
+  fill |= opponent & (fill << shift);
+  opponent &= opponent << shift;
+  fill |= opponent & (fill << (shift * 2));
+  opponent &= opponent << (shift * 2);
+  fill |= opponent & (fill << (shift * 4));
+
+  return fill;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FillRight(
+    uint64_t self, uint64_t opponent, int32_t shift) {
+  uint64_t fill = opponent & (self >> shift);
+
+  fill |= opponent & (fill >> shift);
+  opponent &= opponent >> shift;
+  fill |= opponent & (fill >> (shift * 2));
+  opponent &= opponent >> (shift * 2);
+  fill |= opponent & (fill >> (shift * 4));
+
+  return fill;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::ValidMoves(uint64_t self, uint64_t opponent) {
+  const uint64_t inner = opponent & Bitboard::kInnerColumns;
+
+  uint64_t moves = 0;
+
+  // Horizontal.
+  moves |= Bitboard::FillLeft(self, inner, 1) << 1;
+  moves |= Bitboard::FillRight(self, inner, 1) >> 1;
+
+  // Vertical.
+  moves |= Bitboard::FillLeft(self, opponent, 8) << 8;
+  moves |= Bitboard::FillRight(self, opponent, 8) >> 8;
+
+  // Diagonals.
+  moves |= Bitboard::FillLeft(self, inner, 7) << 7;
+  moves |= Bitboard::FillRight(self, inner, 7) >> 7;
+  moves |= Bitboard::FillLeft(self, inner, 9) << 9;
+  moves |= Bitboard::FillRight(self, inner, 9) >> 9;
+
+  return moves & ~(self | opponent);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Flanked(uint64_t fill, uint64_t end, uint64_t self) {
+  // All ones when end hits self, else all zeros.
+  return fill & (0ull - static_cast<uint64_t>((end & self) != 0));
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FlipsScalar(
+    uint64_t self, uint64_t opponent, uint64_t move) {
+  const uint64_t inner = opponent & Bitboard::kInnerColumns;
+
+  uint64_t flips = 0, fill;
+
+  fill = Bitboard::FillLeft(move, inner, 1);
+  flips |= Bitboard::Flanked(fill, fill << 1, self);
+  fill = Bitboard::FillRight(move, inner, 1);
+  flips |= Bitboard::Flanked(fill, fill >> 1, self);
+
+  fill = Bitboard::FillLeft(move, opponent, 8);
+  flips |= Bitboard::Flanked(fill, fill << 8, self);
+  fill = Bitboard::FillRight(move, opponent, 8);
+  flips |= Bitboard::Flanked(fill, fill >> 8, self);
+
+  fill = Bitboard::FillLeft(move, inner, 7);
+  flips |= Bitboard::Flanked(fill, fill << 7, self);
+  fill = Bitboard::FillRight(move, inner, 7);
+  flips |= Bitboard::Flanked(fill, fill >> 7, self);
+
+  fill = Bitboard::FillLeft(move, inner, 9);
+  flips |= Bitboard::Flanked(fill, fill << 9, self);
+  fill = Bitboard::FillRight(move, inner, 9);
+  flips |= Bitboard::Flanked(fill, fill >> 9, self);
+
+  return flips;
+}
+
+#ifdef __AVX2__
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::FlipsAvx2(
+    uint64_t self, uint64_t opponent, uint64_t move) {
+  // One direction pair (left / right shift) per lane.
+  const __m256i shift1 = _mm256_set_epi64x(9, 7, 8, 1);
+  const __m256i shift2 = _mm256_add_epi64(shift1, shift1);
+  const __m256i shift4 = _mm256_add_epi64(shift2, shift2);
+  const __m256i mask = _mm256_set_epi64x(
+    Bitboard::kInnerColumns, Bitboard::kInnerColumns, -1,
+    Bitboard::kInnerColumns);
+  const __m256i zero = _mm256_setzero_si256();
+
+  const __m256i s = _mm256_set1_epi64x(self);
+  const __m256i o = _mm256_and_si256(_mm256_set1_epi64x(opponent), mask);
+  const __m256i m = _mm256_set1_epi64x(move);
+
+  __m256i fill, pro, end, flips;
+
+  // Left shifts.
+  fill = _mm256_and_si256(o, _mm256_sllv_epi64(m, shift1));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(o, _mm256_sllv_epi64(fill, shift1)));
+  pro = _mm256_and_si256(o, _mm256_sllv_epi64(o, shift1));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(pro, _mm256_sllv_epi64(fill, shift2)));
+  pro = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, shift2));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(pro, _mm256_sllv_epi64(fill, shift4)));
+  end = _mm256_and_si256(s, _mm256_sllv_epi64(fill, shift1));
+  flips = _mm256_andnot_si256(_mm256_cmpeq_epi64(end, zero), fill);
+
+  // Right shifts.
+  fill = _mm256_and_si256(o, _mm256_srlv_epi64(m, shift1));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(o, _mm256_srlv_epi64(fill, shift1)));
+  pro = _mm256_and_si256(o, _mm256_srlv_epi64(o, shift1));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(pro, _mm256_srlv_epi64(fill, shift2)));
+  pro = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, shift2));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(pro, _mm256_srlv_epi64(fill, shift4)));
+  end = _mm256_and_si256(s, _mm256_srlv_epi64(fill, shift1));
+  flips = _mm256_or_si256(
+    flips, _mm256_andnot_si256(_mm256_cmpeq_epi64(end, zero), fill));
+
+  // Fold the 4 lanes.
+  __m128i half = _mm_or_si128(
+    _mm256_castsi256_si128(flips), _mm256_extracti128_si256(flips, 1));
+
+  half = _mm_or_si128(half, _mm_unpackhi_epi64(half, half));
+
+  return static_cast<uint64_t>(_mm_cvtsi128_si64(half));
+}
+#endif  // __AVX2__
+
+//------------------------------------------------------------------------------
+inline uint64_t Bitboard::Flips(
+    uint64_t self, uint64_t opponent, uint64_t move) {
+#ifdef __AVX2__
+  return Bitboard::FlipsAvx2(self, opponent, move);
+#else
+  return Bitboard::FlipsScalar(self, opponent, move);
+#endif  // __AVX2__
+}
+
+#ifdef __AVX2__
+//------------------------------------------------------------------------------
+template <int32_t kShift>
+inline __m256i Bitboard::FillLeft4(__m256i self, __m256i opponent) {
+  __m256i fill = _mm256_and_si256(opponent, _mm256_slli_epi64(self, kShift));
+
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_slli_epi64(fill, kShift)));
+  opponent = _mm256_and_si256(opponent, _mm256_slli_epi64(opponent, kShift));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_slli_epi64(fill, kShift * 2)));
+  opponent =
+    _mm256_and_si256(opponent, _mm256_slli_epi64(opponent, kShift * 2));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_slli_epi64(fill, kShift * 4)));
+
+  return fill;
+}
+
+//------------------------------------------------------------------------------
+template <int32_t kShift>
+inline __m256i Bitboard::FillRight4(__m256i self, __m256i opponent) {
+  __m256i fill = _mm256_and_si256(opponent, _mm256_srli_epi64(self, kShift));
+
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_srli_epi64(fill, kShift)));
+  opponent = _mm256_and_si256(opponent, _mm256_srli_epi64(opponent, kShift));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_srli_epi64(fill, kShift * 2)));
+  opponent =
+    _mm256_and_si256(opponent, _mm256_srli_epi64(opponent, kShift * 2));
+  fill = _mm256_or_si256(
+    fill, _mm256_and_si256(opponent, _mm256_srli_epi64(fill, kShift * 4)));
+
+  return fill;
+}
+
+//------------------------------------------------------------------------------
+inline __m256i Bitboard::Flanked4(__m256i fill, __m256i end, __m256i self) {
+  const __m256i miss =
+    _mm256_cmpeq_epi64(_mm256_and_si256(end, self), _mm256_setzero_si256());
+
+  return _mm256_andnot_si256(miss, fill);
+}
+
+//------------------------------------------------------------------------------
+template <int32_t kShift>
+inline __m256i Bitboard::ValidMovesPair4(__m256i self, __m256i opponent) {
+  return _mm256_or_si256(
+    _mm256_slli_epi64(Bitboard::FillLeft4<kShift>(self, opponent), kShift),
+    _mm256_srli_epi64(Bitboard::FillRight4<kShift>(self, opponent), kShift));
+}
+
+//------------------------------------------------------------------------------
+template <int32_t kShift>
+inline __m256i Bitboard::FlipsPair4(
+    __m256i self, __m256i opponent, __m256i move) {
+  const __m256i left = Bitboard::FillLeft4<kShift>(move, opponent);
+  const __m256i right = Bitboard::FillRight4<kShift>(move, opponent);
+
+  return _mm256_or_si256(
+    Bitboard::Flanked4(left, _mm256_slli_epi64(left, kShift), self),
+    Bitboard::Flanked4(right, _mm256_srli_epi64(right, kShift), self));
+}
+#endif  // __AVX2__
+
+//------------------------------------------------------------------------------
+inline void Bitboard::ValidMoves4(
+    const uint64_t* self, const uint64_t* opponent, uint64_t* moves) {
+#ifdef __AVX2__
+  const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(self));
+  const __m256i o =
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(opponent));
+
+  // Directions 1, 7 and 9 wrap around the rows, 8 does not.
+  const __m256i inner =
+    _mm256_and_si256(o, _mm256_set1_epi64x(Bitboard::kInnerColumns));
+
+  __m256i m = Bitboard::ValidMovesPair4<1>(s, inner);
+
+  m = _mm256_or_si256(m, Bitboard::ValidMovesPair4<8>(s, o));
+  m = _mm256_or_si256(m, Bitboard::ValidMovesPair4<7>(s, inner));
+  m = _mm256_or_si256(m, Bitboard::ValidMovesPair4<9>(s, inner));
+  m = _mm256_andnot_si256(_mm256_or_si256(s, o), m);
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(moves), m);
+#else
+  for (auto i = 0; i < Bitboard::kLanes; ++i) {
+    moves[i] = Bitboard::ValidMoves(self[i], opponent[i]);
+  }
+#endif  // __AVX2__
+}
+
+//------------------------------------------------------------------------------
+inline void Bitboard::Flips4(const uint64_t* self, const uint64_t* opponent,
+                             const uint64_t* moves, uint64_t* flips) {
+#ifdef __AVX2__
+  const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(self));
+  const __m256i o =
+    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(opponent));
+  const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(moves));
+  const __m256i inner =
+    _mm256_and_si256(o, _mm256_set1_epi64x(Bitboard::kInnerColumns));
+
+  __m256i f = Bitboard::FlipsPair4<1>(s, inner, m);
+
+  f = _mm256_or_si256(f, Bitboard::FlipsPair4<8>(s, o, m));
+  f = _mm256_or_si256(f, Bitboard::FlipsPair4<7>(s, inner, m));
+  f = _mm256_or_si256(f, Bitboard::FlipsPair4<9>(s, inner, m));
+
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(flips), f);
+#else
+  for (auto i = 0; i < Bitboard::kLanes; ++i) {
+    flips[i] = Bitboard::FlipsScalar(self[i], opponent[i], moves[i]);
+  }
+#endif  // __AVX2__
+}
+
+#endif  // REVERSI_BITBOARD_H__
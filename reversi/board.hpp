@@ -0,0 +1,183 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_BOARD_H__
+#define REVERSI_BOARD_H__
+
+#include <cstdint>
+#include "../uct/arena.hpp"
+#include "bitboard.hpp"
+#include "endgame.hpp"
+#include "reversi.hpp"
+#include "zobrist.hpp"
+
+// A reversi position packed into 17 bytes, the board of ReversiGame. player
+// is a ReversiState::Player.
+#pragma pack(push, 1)
+struct ReversiBoard {
+  uint64_t  blacks;
+  uint64_t  whites;
+  uint8_t   player;
+};
+#pragma pack(pop)
+
+// Game traits of reversi for Uct, statically dispatched to the bitboard
+// routines of ReversiState.
+class ReversiGame {
+ public:
+  typedef ReversiBoard Board;
+
+  // A move is an empty square, there are less than 64.
+  static const int32_t kMaxChildren = 64;
+
+  static Board Clone(const Board& board, Arena* arena);
+  static bool IsEnd(const Board& board);
+  static bool IsSame(const Board& a, const Board& b);
+  static uint64_t Hash(const Board& board);
+  static int32_t Expand(const Board& board, Arena* arena, Board* children);
+  static int32_t Simulate(const Board& board, Random* random);
+
+  // Simulate each of count boards into winners, in lockstep batches (see
+  // ReversiState::Playouts). Boards may repeat for more playouts of one.
+  static void Simulate(const Board* boards, int32_t count, Random* random,
+                       int32_t* winners);
+
+  static float Reward(const Board& board, int32_t winner);
+  static int32_t Outcome(const Board& board);
+  static bool Solve(const Board& board, int32_t depth, Arena* arena,
+                    Board* best, int32_t* score);
+  static void Inspect(const Board& board);
+};
+
+//------------------------------------------------------------------------------
+inline ReversiGame::Board ReversiGame::Clone(
+    const Board& board, Arena* arena) {
+  return board;
+}
+
+//------------------------------------------------------------------------------
+inline bool ReversiGame::IsEnd(const Board& board) {
+  return
+    Bitboard::ValidMoves(board.blacks, board.whites) == 0 &&
+    Bitboard::ValidMoves(board.whites, board.blacks) == 0;
+}
+
+//------------------------------------------------------------------------------
+inline bool ReversiGame::IsSame(const Board& a, const Board& b) {
+  return a.blacks == b.blacks && a.whites == b.whites && a.player == b.player;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t ReversiGame::Hash(const Board& board) {
+  // Symmetric positions are worth the same, they share a hash and so their
+  // statistics. The packed board has no room for the hash, it is computed
+  // from scratch.
+  uint64_t blacks = board.blacks, whites = board.whites;
+
+  Bitboard::Canonicalize(&blacks, &whites);
+
+  return Zobrist::Hash(
+    blacks, whites, static_cast<ReversiState::Player>(board.player));
+}
+
+//------------------------------------------------------------------------------
+inline int32_t ReversiGame::Expand(
+    const Board& board, Arena* arena, Board* children) {
+  const bool black = (board.player == ReversiState::Player::kBlack);
+  const uint64_t self = black ? board.blacks : board.whites;
+  const uint64_t opponent = black ? board.whites : board.blacks;
+  const uint8_t player = black
+    ? ReversiState::Player::kWhite : ReversiState::Player::kBlack;
+
+  auto moves = Bitboard::ValidMoves(self, opponent);
+
+  if (moves == 0) {
+    // Not an end, the only move is a pass.
+    children[0] = board;
+    children[0].player = player;
+
+    return 1;
+  }
+
+  auto count = 0;
+
+  for (; moves != 0; moves &= moves - 1) {
+    const uint64_t move = moves & (~moves + 1);
+    const uint64_t flips = Bitboard::Flips(self, opponent, move);
+
+    auto& child = children[count++];
+
+    child.blacks = board.blacks ^ flips ^ (black ? move : 0);
+    child.whites = board.whites ^ flips ^ (black ? 0 : move);
+    child.player = player;
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+inline int32_t ReversiGame::Simulate(const Board& board, Random* random) {
+  return ReversiState::Playout(
+    board.blacks,
+    board.whites,
+    static_cast<ReversiState::Player>(board.player),
+    random);
+}
+
+//------------------------------------------------------------------------------
+inline void ReversiGame::Simulate(const Board* boards, int32_t count,
+                                  Random* random, int32_t* winners) {
+  ReversiState::Playouts(boards, count, random, winners);
+}
+
+//------------------------------------------------------------------------------
+inline float ReversiGame::Reward(const Board& board, int32_t winner) {
+  // board.player did not move into this board, a draw counts as a win.
+  return board.player == winner ? 0.0f : 1.0f;
+}
+
+//------------------------------------------------------------------------------
+inline int32_t ReversiGame::Outcome(const Board& board) {
+  const auto blacks = Bitboard::Count(board.blacks);
+  const auto whites = Bitboard::Count(board.whites);
+
+  if (blacks == whites) { return 0; }
+
+  // board.player did not move into this board.
+  const bool black = (board.player == ReversiState::Player::kBlack);
+
+  return (blacks > whites) == black ? -1 : 1;
+}
+
+//------------------------------------------------------------------------------
+inline bool ReversiGame::Solve(const Board& board, int32_t depth,
+                               Arena* arena, Board* best, int32_t* score) {
+  // depth is the number of empty squares, an upper bound of the moves left.
+  if (Bitboard::Count(~(board.blacks | board.whites)) > depth ||
+      ReversiGame::IsEnd(board)) {
+    return false;
+  }
+
+  const bool black = (board.player == ReversiState::Player::kBlack);
+  const uint64_t self = black ? board.blacks : board.whites;
+  const uint64_t opponent = black ? board.whites : board.blacks;
+
+  uint64_t move;
+
+  *score = EndgameSolver::OfThread().Solve(self, opponent, &move);
+
+  // No move is a pass.
+  const uint64_t flips = move ? Bitboard::Flips(self, opponent, move) : 0;
+
+  best->blacks = board.blacks ^ flips ^ (black ? move : 0);
+  best->whites = board.whites ^ flips ^ (black ? 0 : move);
+  best->player = black
+    ? ReversiState::Player::kWhite : ReversiState::Player::kBlack;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+inline void ReversiGame::Inspect(const Board& board) {
+  ReversiState(board).Inspect();
+}
+
+#endif  // REVERSI_BOARD_H__
@@ -0,0 +1,221 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bitboard.hpp"
+#include "book.hpp"
+#include "zobrist.hpp"
+
+using std::fclose;
+using std::fopen;
+using std::fwrite;
+using std::lower_bound;
+using std::max;
+using std::memcmp;
+using std::memcpy;
+using std::min;
+using std::sort;
+using std::vector;
+
+namespace {
+const char kMagic[8] = {'R', 'V', 'B', 'O', 'O', 'K', '\0', '\0'};
+}  // namespace
+
+//------------------------------------------------------------------------------
+OpeningBook::OpeningBook() : memory_(MAP_FAILED), size_(0),
+    entries_(nullptr), count_entries_(0) {
+}
+
+//------------------------------------------------------------------------------
+OpeningBook::~OpeningBook() {
+  this->Close();
+}
+
+//------------------------------------------------------------------------------
+bool OpeningBook::Open(const char* path) {
+  this->Close();
+
+  const auto file = open(path, O_RDONLY);
+
+  if (file < 0) { return false; }
+
+  struct stat status;
+
+  if (fstat(file, &status) != 0 ||
+      static_cast<size_t>(status.st_size) < sizeof(Header)) {
+    close(file);
+
+    return false;
+  }
+
+  const auto size = static_cast<size_t>(status.st_size);
+  const auto memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+  // The mapping keeps the file.
+  close(file);
+
+  if (memory == MAP_FAILED) { return false; }
+
+  Header header;
+
+  memcpy(&header, memory, sizeof(header));
+
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion ||
+      size != sizeof(Header) + header.count_entries * sizeof(Entry)) {
+    munmap(memory, size);
+
+    return false;
+  }
+
+  this->memory_ = memory;
+  this->size_ = size;
+  this->entries_ = reinterpret_cast<const Entry*>(
+    static_cast<const uint8_t*>(memory) + sizeof(Header));
+  this->count_entries_ = header.count_entries;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void OpeningBook::Close() {
+  if (this->memory_ == MAP_FAILED) { return; }
+
+  munmap(this->memory_, this->size_);
+
+  this->memory_ = MAP_FAILED;
+  this->size_ = 0;
+  this->entries_ = nullptr;
+  this->count_entries_ = 0;
+}
+
+//------------------------------------------------------------------------------
+bool OpeningBook::IsOpen() const {
+  return this->memory_ != MAP_FAILED;
+}
+
+//------------------------------------------------------------------------------
+size_t OpeningBook::CountEntries() const {
+  return this->count_entries_;
+}
+
+//------------------------------------------------------------------------------
+bool OpeningBook::Probe(const ReversiBoard& board, uint32_t count_min_visits,
+                        ReversiBoard* move) const {
+  int32_t k;
+
+  const auto key = OpeningBook::KeyOf(board, &k);
+  const auto end = this->entries_ + this->count_entries_;
+
+  const Entry* best = nullptr;
+
+  auto entry = lower_bound(this->entries_, end, key,
+    [](const Entry& a, uint64_t b) { return a.key < b; });
+
+  for (; entry != end && entry->key == key; ++entry) {
+    if (best == nullptr || best->count_visits < entry->count_visits) {
+      best = entry;
+    }
+  }
+
+  if (best == nullptr || best->count_visits < count_min_visits) {
+    return false;
+  }
+
+  const bool black = (board.player == ReversiState::Player::kBlack);
+  const uint64_t self = black ? board.blacks : board.whites;
+  const uint64_t opponent = black ? board.whites : board.blacks;
+
+  auto moves = Bitboard::ValidMoves(self, opponent);
+
+  // A hash collision or a broken book.
+  if ((moves == 0) != (best->square == kPass)) { return false; }
+
+  // Map the square back by mapping the valid moves forth, any of the moves
+  // of a symmetric position which land on it is as good. Nothing for a pass.
+  uint64_t square = 0;
+
+  for (; moves != 0 && square == 0; moves &= moves - 1) {
+    const uint64_t candidate = moves & (~moves + 1);
+
+    if (Bitboard::Symmetry(candidate, k) == (1ull << best->square)) {
+      square = candidate;
+    }
+  }
+
+  if (square == 0 && best->square != kPass) { return false; }
+
+  const uint64_t flips =
+    square != 0 ? Bitboard::Flips(self, opponent, square) : 0;
+
+  move->blacks = board.blacks ^ flips ^ (black ? square : 0);
+  move->whites = board.whites ^ flips ^ (black ? 0 : square);
+  move->player = black
+    ? ReversiState::Player::kWhite : ReversiState::Player::kBlack;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+OpeningBook::Entry OpeningBook::EntryOf(
+    const ReversiBoard& board, const ReversiBoard& child,
+    uint32_t count_visits, float win_rate) {
+  int32_t k;
+
+  Entry entry;
+
+  entry.key = OpeningBook::KeyOf(board, &k);
+  entry.count_visits = count_visits;
+  entry.win_rate = static_cast<uint16_t>(
+    min(max(win_rate, 0.0f), 1.0f) * 65535.0f + 0.5f);
+  entry.reserved = 0;
+
+  // The new stone, nothing for a pass.
+  const auto square =
+    (child.blacks | child.whites) & ~(board.blacks | board.whites);
+
+  entry.square = square == 0 ? kPass : static_cast<uint8_t>(
+    Bitboard::IndexOfLowest(Bitboard::Symmetry(square, k)));
+
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+bool OpeningBook::Write(const char* path, vector<Entry> entries) {
+  sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    return a.key < b.key || (a.key == b.key && a.square < b.square);
+  });
+
+  Header header;
+
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.count_entries = static_cast<uint32_t>(entries.size());
+
+  auto file = fopen(path, "wb");
+
+  if (file == nullptr) { return false; }
+
+  auto is_written =
+    fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(entries.data(), sizeof(Entry), entries.size(), file) ==
+      entries.size();
+
+  is_written = (fclose(file) == 0) && is_written;
+
+  return is_written;
+}
+
+//------------------------------------------------------------------------------
+uint64_t OpeningBook::KeyOf(const ReversiBoard& board, int32_t* k) {
+  *k = Bitboard::CanonicalSymmetry(board.blacks, board.whites);
+
+  return Zobrist::Hash(
+    Bitboard::Symmetry(board.blacks, *k),
+    Bitboard::Symmetry(board.whites, *k),
+    static_cast<ReversiState::Player>(board.player));
+}
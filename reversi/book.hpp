@@ -0,0 +1,91 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_BOOK_H__
+#define REVERSI_BOOK_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "board.hpp"
+
+// An opening book: the statistics of the moves searched from the positions
+// of the openings, in a file mapped read-only into memory, so opening one
+// costs no reading and no copying and the pages are shared by all processes
+// using the same book.
+//
+// Positions are keyed by the Zobrist hash of their canonical form (see
+// Bitboard::Canonicalize) and moves are kept in the frame of the canonical
+// form, a book entry serves all 8 symmetric positions. The file is a Header
+// and the entries sorted by key, in the byte order of the host:
+//
+//   Header  header;
+//   Entry   entries[header.count_entries];
+//
+// A probe is a binary search over the mapped entries.
+class OpeningBook {
+ public:
+  struct Header {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  count_entries;
+  };
+
+  // One move of a position.
+  struct Entry {
+    uint64_t  key;
+
+    // Visits of the move, and its wins over its visits times 65535.
+    uint32_t  count_visits;
+    uint16_t  win_rate;
+
+    // Index of the square in the canonical frame, kPass for a pass.
+    uint8_t   square;
+    uint8_t   reserved;
+  };
+
+  static const uint8_t kPass = 64;
+  static const uint32_t kVersion = 1;
+
+ public:
+  OpeningBook();
+  ~OpeningBook();
+
+  OpeningBook(const OpeningBook&) = delete;
+  OpeningBook& operator=(const OpeningBook&) = delete;
+
+  // Map the book at path, closing the one opened before. Return false if the
+  // file can not be mapped or is not a book.
+  bool Open(const char* path);
+
+  // Does nothing if no book is open.
+  void Close();
+
+  bool IsOpen() const;
+
+  size_t CountEntries() const;
+
+  // Put the child of board by its most visited move into move and return
+  // true. Return false if board is not in the book, or if the move has less
+  // than count_min_visits visits.
+  bool Probe(const ReversiBoard& board, uint32_t count_min_visits,
+             ReversiBoard* move) const;
+
+  // The entry of the move from board to child.
+  static Entry EntryOf(const ReversiBoard& board, const ReversiBoard& child,
+                       uint32_t count_visits, float win_rate);
+
+  // Sort entries and write them into a book at path. Return false if the
+  // file can not be written.
+  static bool Write(const char* path, std::vector<Entry> entries);
+
+  // Key of the canonical form of board, k of Bitboard::Symmetry takes board
+  // into the canonical frame.
+  static uint64_t KeyOf(const ReversiBoard& board, int32_t* k);
+
+ private:
+  void*         memory_;
+  size_t        size_;
+  const Entry*  entries_;
+  size_t        count_entries_;
+};
+
+#endif  // REVERSI_BOOK_H__
@@ -0,0 +1,478 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include "bitboard.hpp"
+#include "endgame.hpp"
+
+using std::max;
+using std::min;
+
+namespace {
+// Below every score, the best score before any move is tried.
+const int32_t kNoScore = -EndgameSolver::kMaxScore - 1;
+
+// The 4 quadrants of the board. Late in the game empties are cut into
+// regions, roughly the quadrants, and having the last move in a region is an
+// advantage: moving into a region with an odd number of empties first tends
+// to keep it.
+const uint64_t kQuadrants[4] = {
+  0x000000000f0f0f0full, 0x00000000f0f0f0f0ull,
+  0x0f0f0f0f00000000ull, 0xf0f0f0f000000000ull,
+};
+
+//------------------------------------------------------------------------------
+// Squares in the quadrants with an odd number of empties.
+uint64_t OddQuadrants(uint64_t empties) {
+  uint64_t odd = 0;
+
+  for (auto quadrant : kQuadrants) {
+    if (Bitboard::Count(empties & quadrant) & 1) {
+      odd |= quadrant;
+    }
+  }
+
+  return odd;
+}
+
+//------------------------------------------------------------------------------
+// Index into a table of size mask + 1.
+size_t IndexOf(uint64_t self, uint64_t opponent, size_t mask) {
+  auto hash = self * 0x9e3779b97f4a7c15ull ^ opponent * 0xc2b2ae3d27d4eb4full;
+
+  return static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+}
+}  // namespace
+
+//------------------------------------------------------------------------------
+EndgameSolver::EndgameSolver(size_t table_size) : mask_(0), count_nodes_(0) {
+  size_t count_entries = 1;
+
+  while (count_entries * 2 * sizeof(Entry) <= table_size) {
+    count_entries *= 2;
+  }
+
+  // No position has no stone, empty entries never match.
+  Entry empty = {0, 0, -kMaxScore, kMaxScore, kNoMove};
+
+  this->entries_.assign(count_entries, empty);
+  this->mask_ = count_entries - 1;
+}
+
+//------------------------------------------------------------------------------
+EndgameSolver& EndgameSolver::OfThread() {
+  static thread_local EndgameSolver solver;
+
+  return solver;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::FinalScore(uint64_t self, uint64_t opponent) {
+  const auto count_self = Bitboard::Count(self);
+  const auto count_opponent = Bitboard::Count(opponent);
+  const auto count_empties = 64 - count_self - count_opponent;
+  const auto score = count_self - count_opponent;
+
+  if (score > 0) { return score + count_empties; }
+  if (score < 0) { return score - count_empties; }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Solve(
+    uint64_t self, uint64_t opponent, uint64_t* move) {
+  this->count_nodes_ += 1;
+
+  auto& entry = this->EntryOf(self, opponent);
+
+  const auto hint = (entry.self == self && entry.opponent == opponent &&
+                     entry.best != kNoMove) ? (1ull << entry.best) : 0;
+
+  uint64_t moves[64];
+
+  const auto count_moves = this->SortMoves(self, opponent, hint, moves);
+
+  *move = 0;
+
+  if (count_moves == 0) {
+    if (Bitboard::ValidMoves(opponent, self) == 0) {
+      return FinalScore(self, opponent);
+    }
+
+    return -this->Search(opponent, self, -kMaxScore, kMaxScore, true);
+  }
+
+  auto alpha = kNoScore;
+
+  // Principal variation search: the first move gets the full window, the
+  // others are only proven worse with a null window, and searched again if
+  // they are not.
+  for (auto i = 0; i < count_moves; ++i) {
+    const auto flips = Bitboard::Flips(self, opponent, moves[i]);
+    const auto next_self = opponent ^ flips;
+    const auto next_opponent = self ^ flips ^ moves[i];
+
+    int32_t score;
+
+    if (i == 0) {
+      score = -this->Search(next_self, next_opponent, -kMaxScore, kMaxScore,
+                            false);
+    } else {
+      score = -this->Search(next_self, next_opponent, -alpha - 1, -alpha,
+                            false);
+
+      if (score > alpha) {
+        score = -this->Search(next_self, next_opponent, -kMaxScore, -score,
+                              false);
+      }
+    }
+
+    if (score > alpha) {
+      alpha = score;
+      *move = moves[i];
+    }
+  }
+
+  auto& result = this->EntryOf(self, opponent);
+
+  result.self = self;
+  result.opponent = opponent;
+  result.lower = static_cast<int8_t>(alpha);
+  result.upper = static_cast<int8_t>(alpha);
+  result.best = static_cast<uint8_t>(Bitboard::IndexOfLowest(*move));
+
+  return alpha;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Search(uint64_t self, uint64_t opponent,
+                              int32_t alpha, int32_t beta, bool passed) {
+  if (Bitboard::Count(~(self | opponent)) <= kShallowEmpties) {
+    return this->Shallow(self, opponent, alpha, beta, passed);
+  }
+
+  this->count_nodes_ += 1;
+
+  int32_t lower = -kMaxScore, upper = kMaxScore;
+  uint64_t hint = 0;
+
+  {
+    const auto& entry = this->EntryOf(self, opponent);
+
+    if (entry.self == self && entry.opponent == opponent) {
+      lower = entry.lower;
+      upper = entry.upper;
+
+      if (lower >= beta) { return lower; }
+      if (upper <= alpha) { return upper; }
+      if (lower == upper) { return lower; }
+
+      alpha = max(alpha, lower);
+      beta = min(beta, upper);
+
+      hint = (entry.best != kNoMove) ? (1ull << entry.best) : 0;
+    }
+  }
+
+  uint64_t moves[64];
+
+  const auto count_moves = this->SortMoves(self, opponent, hint, moves);
+
+  if (count_moves == 0) {
+    if (passed) { return FinalScore(self, opponent); }
+
+    return -this->Search(opponent, self, -beta, -alpha, true);
+  }
+
+  const auto window_alpha = alpha;
+
+  auto best = kNoScore;
+  auto best_move = moves[0];
+
+  for (auto i = 0; i < count_moves; ++i) {
+    const auto flips = Bitboard::Flips(self, opponent, moves[i]);
+    const auto next_self = opponent ^ flips;
+    const auto next_opponent = self ^ flips ^ moves[i];
+
+    int32_t score;
+
+    if (i == 0) {
+      score = -this->Search(next_self, next_opponent, -beta, -alpha, false);
+    } else {
+      score = -this->Search(next_self, next_opponent, -alpha - 1, -alpha,
+                            false);
+
+      if (score > alpha && score < beta) {
+        score = -this->Search(next_self, next_opponent, -beta, -score,
+                              false);
+      }
+    }
+
+    if (score > best) {
+      best = score;
+      best_move = moves[i];
+
+      if (best >= beta) { break; }
+
+      alpha = max(alpha, best);
+    }
+  }
+
+  // The children may have taken over the entry, it is looked up again.
+  if (best <= window_alpha) {
+    upper = min(upper, best);
+  } else if (best >= beta) {
+    lower = max(lower, best);
+  } else {
+    lower = upper = best;
+  }
+
+  auto& entry = this->EntryOf(self, opponent);
+
+  entry.self = self;
+  entry.opponent = opponent;
+  entry.lower = static_cast<int8_t>(lower);
+  entry.upper = static_cast<int8_t>(upper);
+  entry.best = static_cast<uint8_t>(Bitboard::IndexOfLowest(best_move));
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Shallow(uint64_t self, uint64_t opponent,
+                               int32_t alpha, int32_t beta, bool passed) {
+  const auto empties = ~(self | opponent);
+  const auto count_empties = Bitboard::Count(empties);
+  const auto odd = OddQuadrants(empties);
+
+  if (count_empties <= 4) {
+    // Squares of the odd quadrants first.
+    uint64_t squares[4] = {0, 0, 0, 0};
+
+    auto count = 0;
+
+    for (auto part = empties & odd; part != 0; part &= part - 1) {
+      squares[count++] = part & (~part + 1);
+    }
+
+    for (auto part = empties & ~odd; part != 0; part &= part - 1) {
+      squares[count++] = part & (~part + 1);
+    }
+
+    switch (count_empties) {
+      case 4:
+        return this->Last4(self, opponent, alpha, beta, squares[0],
+                           squares[1], squares[2], squares[3], passed);
+      case 3:
+        return this->Last3(self, opponent, alpha, beta, squares[0],
+                           squares[1], squares[2], passed);
+      case 2:
+        return this->Last2(self, opponent, alpha, beta, squares[0],
+                           squares[1], passed);
+      case 1:
+        return this->Last1(self, opponent, squares[0]);
+      default:
+        return FinalScore(self, opponent);
+    }
+  }
+
+  this->count_nodes_ += 1;
+
+  auto best = kNoScore;
+
+  // Too close to the end for sorting by mobility to pay, only parity.
+  for (auto part : {empties & odd, empties & ~odd}) {
+    for (; part != 0; part &= part - 1) {
+      const auto move = part & (~part + 1);
+      const auto flips = Bitboard::Flips(self, opponent, move);
+
+      if (flips == 0) { continue; }
+
+      const auto score = -this->Shallow(
+        opponent ^ flips, self ^ flips ^ move, -beta, -max(alpha, best),
+        false);
+
+      if (score > best) {
+        best = score;
+
+        if (best >= beta) { return best; }
+      }
+    }
+  }
+
+  if (best == kNoScore) {
+    if (passed) { return FinalScore(self, opponent); }
+
+    return -this->Shallow(opponent, self, -beta, -alpha, true);
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Last1(uint64_t self, uint64_t opponent, uint64_t s1) {
+  this->count_nodes_ += 1;
+
+  // The board is full after the move, the score is 2 * stones of self - 64.
+  auto flips = Bitboard::Flips(self, opponent, s1);
+
+  if (flips != 0) {
+    return 2 * (Bitboard::Count(self) + Bitboard::Count(flips) + 1) - 64;
+  }
+
+  flips = Bitboard::Flips(opponent, self, s1);
+
+  if (flips != 0) {
+    return 2 * (Bitboard::Count(self) - Bitboard::Count(flips)) - 64;
+  }
+
+  // Nobody can move, the odd count of stones can not be a draw.
+  const auto score = 2 * Bitboard::Count(self) - 63;
+
+  return score > 0 ? score + 1 : score - 1;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Last2(uint64_t self, uint64_t opponent, int32_t alpha,
+                             int32_t beta, uint64_t s1, uint64_t s2,
+                             bool passed) {
+  this->count_nodes_ += 1;
+
+  auto best = kNoScore;
+  auto flips = Bitboard::Flips(self, opponent, s1);
+
+  if (flips != 0) {
+    best = -this->Last1(opponent ^ flips, self ^ flips ^ s1, s2);
+
+    if (best >= beta) { return best; }
+  }
+
+  flips = Bitboard::Flips(self, opponent, s2);
+
+  if (flips != 0) {
+    best = max(best, -this->Last1(opponent ^ flips, self ^ flips ^ s2, s1));
+  }
+
+  if (best == kNoScore) {
+    if (passed) { return FinalScore(self, opponent); }
+
+    return -this->Last2(opponent, self, -beta, -alpha, s1, s2, true);
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Last3(uint64_t self, uint64_t opponent, int32_t alpha,
+                             int32_t beta, uint64_t s1, uint64_t s2,
+                             uint64_t s3, bool passed) {
+  this->count_nodes_ += 1;
+
+  const uint64_t squares[3][3] = {{s1, s2, s3}, {s2, s1, s3}, {s3, s1, s2}};
+
+  auto best = kNoScore;
+
+  for (const auto& s : squares) {
+    const auto flips = Bitboard::Flips(self, opponent, s[0]);
+
+    if (flips == 0) { continue; }
+
+    const auto score = -this->Last2(
+      opponent ^ flips, self ^ flips ^ s[0], -beta, -max(alpha, best), s[1],
+      s[2], false);
+
+    if (score > best) {
+      best = score;
+
+      if (best >= beta) { return best; }
+    }
+  }
+
+  if (best == kNoScore) {
+    if (passed) { return FinalScore(self, opponent); }
+
+    return -this->Last3(opponent, self, -beta, -alpha, s1, s2, s3, true);
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::Last4(uint64_t self, uint64_t opponent, int32_t alpha,
+                             int32_t beta, uint64_t s1, uint64_t s2,
+                             uint64_t s3, uint64_t s4, bool passed) {
+  this->count_nodes_ += 1;
+
+  // s1 ~ s4 are in parity order, the rest keeps it.
+  const uint64_t squares[4][4] = {
+    {s1, s2, s3, s4}, {s2, s1, s3, s4}, {s3, s1, s2, s4}, {s4, s1, s2, s3},
+  };
+
+  auto best = kNoScore;
+
+  for (const auto& s : squares) {
+    const auto flips = Bitboard::Flips(self, opponent, s[0]);
+
+    if (flips == 0) { continue; }
+
+    const auto score = -this->Last3(
+      opponent ^ flips, self ^ flips ^ s[0], -beta, -max(alpha, best), s[1],
+      s[2], s[3], false);
+
+    if (score > best) {
+      best = score;
+
+      if (best >= beta) { return best; }
+    }
+  }
+
+  if (best == kNoScore) {
+    if (passed) { return FinalScore(self, opponent); }
+
+    return -this->Last4(opponent, self, -beta, -alpha, s1, s2, s3, s4, true);
+  }
+
+  return best;
+}
+
+//------------------------------------------------------------------------------
+int32_t EndgameSolver::SortMoves(uint64_t self, uint64_t opponent,
+                                 uint64_t best, uint64_t* moves) const {
+  const auto odd = OddQuadrants(~(self | opponent));
+
+  int32_t keys[64];
+
+  auto count = 0;
+
+  for (auto all = Bitboard::ValidMoves(self, opponent); all != 0;
+       all &= all - 1) {
+    const auto move = all & (~all + 1);
+    const auto flips = Bitboard::Flips(self, opponent, move);
+
+    // Fastest first: the fewer replies, the sooner the cut. Parity breaks
+    // the ties.
+    auto key = 2 * Bitboard::Count(
+      Bitboard::ValidMoves(opponent ^ flips, self ^ flips ^ move));
+
+    if ((move & odd) == 0) { key += 1; }
+    if (move == best) { key = -1; }
+
+    // Insertion sort, there are a few moves.
+    auto i = count++;
+
+    for (; i > 0 && keys[i - 1] > key; --i) {
+      keys[i] = keys[i - 1];
+      moves[i] = moves[i - 1];
+    }
+
+    keys[i] = key;
+    moves[i] = move;
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+EndgameSolver::Entry& EndgameSolver::EntryOf(
+    uint64_t self, uint64_t opponent) {
+  return this->entries_[IndexOf(self, opponent, this->mask_)];
+}
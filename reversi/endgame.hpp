@@ -0,0 +1,101 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_ENDGAME_H__
+#define REVERSI_ENDGAME_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Exact solver of reversi endgames, a negamax alpha-beta search over
+// bitboards. Scores are final disc differences for the player to move, the
+// empty squares going to the winner, so they are in [-64, 64].
+//
+// Moves are ordered by the position in the table, then fastest-first (the
+// fewest replies of the opponent) and parity (odd regions first). Positions
+// with a few empties are searched without the table nor sorting, the last 4
+// empties by routines of their own.
+//
+// The table keeps bounds of the scores of whole positions, they hold for
+// every later solve and are never cleared. A solver is not thread safe, use
+// one per thread.
+class EndgameSolver {
+ public:
+  // Bound of the scores.
+  static const int32_t kMaxScore = 64;
+
+  // Bytes of the table of a default solver.
+  static const size_t kDefaultTableSize = 16 << 20;
+
+ public:
+  // Use at most table_size bytes for the table, at least one entry.
+  explicit EndgameSolver(size_t table_size = kDefaultTableSize);
+
+  EndgameSolver(const EndgameSolver&) = delete;
+  EndgameSolver& operator=(const EndgameSolver&) = delete;
+
+  // Score of (self, opponent) with self to move. The best move (a one bit
+  // mask) goes into move, 0 if self has to pass or the game has ended.
+  int32_t Solve(uint64_t self, uint64_t opponent, uint64_t* move);
+
+  // Positions searched by all solves.
+  uint64_t CountNodes() const;
+
+  // The solver of the calling thread, with a default table.
+  static EndgameSolver& OfThread();
+
+  // Score of the ended game (self, opponent).
+  static int32_t FinalScore(uint64_t self, uint64_t opponent);
+
+ private:
+  // Positions with at most this many empties are searched by Shallow.
+  static const int32_t kShallowEmpties = 7;
+
+  // Entry::best of a position without a move.
+  static const uint8_t kNoMove = 64;
+
+  struct Entry {
+    uint64_t  self;
+    uint64_t  opponent;
+    int8_t    lower;
+    int8_t    upper;
+
+    // Index of the best move found, kNoMove if there is none.
+    uint8_t   best;
+  };
+
+  // All searches are fail-soft: a score <= alpha is an upper bound, a score
+  // >= beta is a lower bound and any other score is exact. passed is true if
+  // the opponent just passed.
+  int32_t Search(uint64_t self, uint64_t opponent, int32_t alpha,
+                 int32_t beta, bool passed);
+  int32_t Shallow(uint64_t self, uint64_t opponent, int32_t alpha,
+                  int32_t beta, bool passed);
+
+  // The last empties are the squares s1 ~ s4 (one bit masks).
+  int32_t Last1(uint64_t self, uint64_t opponent, uint64_t s1);
+  int32_t Last2(uint64_t self, uint64_t opponent, int32_t alpha,
+                int32_t beta, uint64_t s1, uint64_t s2, bool passed);
+  int32_t Last3(uint64_t self, uint64_t opponent, int32_t alpha,
+                int32_t beta, uint64_t s1, uint64_t s2, uint64_t s3,
+                bool passed);
+  int32_t Last4(uint64_t self, uint64_t opponent, int32_t alpha,
+                int32_t beta, uint64_t s1, uint64_t s2, uint64_t s3,
+                uint64_t s4, bool passed);
+
+  // Put the moves of self into moves, best first, return how many there are.
+  int32_t SortMoves(uint64_t self, uint64_t opponent, uint64_t best,
+                    uint64_t* moves) const;
+
+  Entry& EntryOf(uint64_t self, uint64_t opponent);
+
+  std::vector<Entry>  entries_;
+  size_t              mask_;
+  uint64_t            count_nodes_;
+};
+
+//------------------------------------------------------------------------------
+inline uint64_t EndgameSolver::CountNodes() const {
+  return this->count_nodes_;
+}
+
+#endif  // REVERSI_ENDGAME_H__
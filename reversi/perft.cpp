@@ -0,0 +1,257 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <thread>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "perft.hpp"
+
+using std::memory_order_relaxed;
+using std::pair;
+using std::thread;
+using std::vector;
+
+namespace {
+//------------------------------------------------------------------------------
+// Index into a table of size mask + 1.
+size_t IndexOf(uint64_t self, uint64_t opponent, int32_t depth, size_t mask) {
+  auto hash = self * 0x9e3779b97f4a7c15ull ^ opponent * 0xc2b2ae3d27d4eb4full;
+
+  hash ^= static_cast<uint64_t>(depth) * 0x165667b19e3779f9ull;
+
+  return static_cast<size_t>(hash ^ (hash >> 29)) & mask;
+}
+}  // namespace
+
+//------------------------------------------------------------------------------
+Perft::Perft(int32_t count_threads, size_t table_size)
+    : count_threads_(std::max(count_threads, 1)), mask_(0), count_hits_(0) {
+  if (table_size < sizeof(Entry)) { return; }
+
+  // The largest power of 2 entries which fit.
+  size_t count_entries = 1;
+
+  while (count_entries * 2 * sizeof(Entry) <= table_size) {
+    count_entries *= 2;
+  }
+
+  this->entries_.reset(new Entry[count_entries]);
+  this->mask_ = count_entries - 1;
+
+  for (size_t i = 0; i < count_entries; ++i) {
+    for (auto& word : this->entries_[i].words) {
+      word.store(0, memory_order_relaxed);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+uint64_t Perft::Count(const ReversiState& state, int32_t depth) {
+  if (depth == 0) { return 1; }
+
+  const auto board = state.ToBoard();
+  const auto black = (board.player == ReversiState::Player::kBlack);
+  const auto self = black ? board.blacks : board.whites;
+  const auto opponent = black ? board.whites : board.blacks;
+
+  // An ended game is a leaf.
+  if (Bitboard::ValidMoves(self, opponent) == 0 &&
+      Bitboard::ValidMoves(opponent, self) == 0) {
+    return 1;
+  }
+
+  uint64_t count = 0;
+
+  for (const auto& division : this->Divide(state, depth)) {
+    count += division.second;
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+vector<pair<ReversiState::Move, uint64_t>> Perft::Divide(
+    const ReversiState& state, int32_t depth) {
+  vector<pair<ReversiState::Move, uint64_t>> divisions;
+
+  const auto board = state.ToBoard();
+  const auto black = (board.player == ReversiState::Player::kBlack);
+  const auto self = black ? board.blacks : board.whites;
+  const auto opponent = black ? board.whites : board.blacks;
+
+  auto moves = Bitboard::ValidMoves(self, opponent);
+
+  if (depth <= 0) { return divisions; }
+
+  // The first moves, then the positions below them until there are enough
+  // for the threads.
+  vector<Task> tasks;
+
+  if (moves != 0) {
+    for (; moves != 0; moves &= moves - 1) {
+      const auto move = moves & (~moves + 1);
+      const auto flips = Bitboard::Flips(self, opponent, move);
+      const auto index = Bitboard::IndexOfLowest(move);
+
+      tasks.push_back({opponent ^ flips, self ^ flips ^ move, depth - 1,
+                       static_cast<int32_t>(divisions.size())});
+
+      divisions.emplace_back(ReversiState::Move(index % 8, index / 8), 0);
+    }
+  } else if (Bitboard::ValidMoves(opponent, self) != 0) {
+    tasks.push_back({opponent, self, depth - 1, 0});
+
+    divisions.emplace_back(ReversiState::Move(-1, -1), 0);
+  }
+
+  const size_t count_tasks =
+    this->count_threads_ > 1 ? this->count_threads_ * kTasksPerThread : 0;
+
+  for (auto is_split = true; is_split && tasks.size() < count_tasks;) {
+    vector<Task> children;
+
+    is_split = false;
+
+    for (const auto& task : tasks) {
+      auto moves = Bitboard::ValidMoves(task.self, task.opponent);
+
+      // Leaves and ends stay, and so do passes, which are rare.
+      if (task.depth <= 1 || moves == 0) {
+        children.push_back(task);
+
+        continue;
+      }
+
+      for (; moves != 0; moves &= moves - 1) {
+        const auto move = moves & (~moves + 1);
+        const auto flips = Bitboard::Flips(task.self, task.opponent, move);
+
+        children.push_back({task.opponent ^ flips, task.self ^ flips ^ move,
+                            task.depth - 1, task.first_move});
+      }
+
+      is_split = true;
+    }
+
+    tasks.swap(children);
+  }
+
+  vector<uint64_t> counts(tasks.size(), 0);
+
+  this->CountTasks(tasks, &counts);
+
+  for (size_t i = 0; i < tasks.size(); ++i) {
+    divisions[tasks[i].first_move].second += counts[i];
+  }
+
+  return divisions;
+}
+
+//------------------------------------------------------------------------------
+uint64_t Perft::CountHits() const {
+  return this->count_hits_.load(memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+uint64_t Perft::CountOf(uint64_t self, uint64_t opponent, int32_t depth) {
+  if (depth == 0) { return 1; }
+
+  auto moves = Bitboard::ValidMoves(self, opponent);
+
+  // A pass and an end are one path each.
+  if (depth == 1) {
+    return moves != 0 ? Bitboard::Count(moves) : 1;
+  }
+
+  if (moves == 0) {
+    if (Bitboard::ValidMoves(opponent, self) == 0) { return 1; }
+
+    return this->CountOf(opponent, self, depth - 1);
+  }
+
+  uint64_t count = 0;
+
+  if (depth >= kMinTableDepth &&
+      this->Lookup(self, opponent, depth, &count)) {
+    return count;
+  }
+
+  for (; moves != 0; moves &= moves - 1) {
+    const auto move = moves & (~moves + 1);
+    const auto flips = Bitboard::Flips(self, opponent, move);
+
+    count += this->CountOf(opponent ^ flips, self ^ flips ^ move, depth - 1);
+  }
+
+  if (depth >= kMinTableDepth) {
+    this->Store(self, opponent, depth, count);
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+void Perft::CountTasks(const vector<Task>& tasks, vector<uint64_t>* counts) {
+  std::atomic<size_t> next(0);
+
+  // Each thread takes the next task until none is left, counts[i] is only
+  // written by the thread which took task i.
+  auto fn_count = [this, &tasks, &next, counts]() {
+    for (auto i = next++; i < tasks.size(); i = next++) {
+      (*counts)[i] =
+        this->CountOf(tasks[i].self, tasks[i].opponent, tasks[i].depth);
+    }
+  };
+
+  vector<thread> threads;
+
+  for (auto i = 1; i < this->count_threads_; ++i) {
+    threads.emplace_back(fn_count);
+  }
+
+  fn_count();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+bool Perft::Lookup(uint64_t self, uint64_t opponent, int32_t depth,
+                   uint64_t* count) {
+  if (!this->entries_) { return false; }
+
+  const auto& entry =
+    this->entries_[IndexOf(self, opponent, depth, this->mask_)];
+
+  const auto word_self = entry.words[0].load(memory_order_relaxed);
+  const auto word_opponent = entry.words[1].load(memory_order_relaxed);
+  const auto data = entry.words[2].load(memory_order_relaxed);
+  const auto check = entry.words[3].load(memory_order_relaxed);
+
+  if (word_self != self || word_opponent != opponent ||
+      (data & 0xff) != static_cast<uint64_t>(depth) ||
+      (self ^ opponent ^ data) != check) {
+    return false;
+  }
+
+  *count = data >> 8;
+
+  this->count_hits_.fetch_add(1, memory_order_relaxed);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void Perft::Store(uint64_t self, uint64_t opponent, int32_t depth,
+                  uint64_t count) {
+  if (!this->entries_) { return; }
+
+  auto& entry = this->entries_[IndexOf(self, opponent, depth, this->mask_)];
+
+  const uint64_t data = (count << 8) | static_cast<uint64_t>(depth);
+
+  entry.words[0].store(self, memory_order_relaxed);
+  entry.words[1].store(opponent, memory_order_relaxed);
+  entry.words[2].store(data, memory_order_relaxed);
+  entry.words[3].store(self ^ opponent ^ data, memory_order_relaxed);
+}
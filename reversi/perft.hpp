@@ -0,0 +1,90 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_PERFT_H__
+#define REVERSI_PERFT_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "reversi.hpp"
+
+// Counts of the move paths of a given length, the oracle of the move
+// generator (Bitboard::ValidMoves and Bitboard::Flips) and a measure of its
+// speed. A pass is a move, as MoveAt(-1, -1) is, and an ended game is a
+// leaf even if it is shallower than the depth. From the opening:
+//
+//   depth  1  2   3    4     5     6      7       8        9
+//   paths  4  12  56  244  1396  8200  55092  390216  3005288
+//
+// The positions some plies down are split among the threads. With a table,
+// the counts of positions reached by several move orders are kept and
+// looked up instead of being counted again. The table is shared by the
+// threads without locks: each entry keeps the xor of its words, an entry
+// torn by two threads writing at once does not match and is a miss.
+class Perft {
+ public:
+  // Bytes of the table of a perft with one.
+  static const size_t kDefaultTableSize = 64 << 20;
+
+ public:
+  // Count on count_threads threads, with a table of at most table_size
+  // bytes, 0 for none.
+  explicit Perft(int32_t count_threads = 1, size_t table_size = 0);
+
+  Perft(const Perft&) = delete;
+  Perft& operator=(const Perft&) = delete;
+
+  // Paths of depth moves from state.
+  uint64_t Count(const ReversiState& state, int32_t depth);
+
+  // Paths of depth moves from state by their first move, in the order of
+  // EnumValidMoves. A pass is Move(-1, -1), nothing if the game has ended.
+  std::vector<std::pair<ReversiState::Move, uint64_t>> Divide(
+    const ReversiState& state, int32_t depth);
+
+  // Table lookups which found a count, over the life of the perft.
+  uint64_t CountHits() const;
+
+ private:
+  // Positions below the root are split among the threads once there are
+  // this many of them per thread.
+  static const int32_t kTasksPerThread = 32;
+
+  // Tables are not used this close to the leaves, counting is cheaper.
+  static const int32_t kMinTableDepth = 3;
+
+  // Words of an entry: self, opponent, data (count << 8 | depth) and the
+  // xor of the 3.
+  struct Entry {
+    std::atomic<uint64_t>  words[4];
+  };
+
+  // A position to count, and the first move which led to it.
+  struct Task {
+    uint64_t  self;
+    uint64_t  opponent;
+    int32_t   depth;
+    int32_t   first_move;
+  };
+
+  // Paths of depth moves from (self, opponent), self to move.
+  uint64_t CountOf(uint64_t self, uint64_t opponent, int32_t depth);
+
+  // Count tasks on all threads, counts[i] is the paths of tasks[i].
+  void CountTasks(const std::vector<Task>& tasks,
+                  std::vector<uint64_t>* counts);
+
+  bool Lookup(uint64_t self, uint64_t opponent, int32_t depth,
+              uint64_t* count);
+  void Store(uint64_t self, uint64_t opponent, int32_t depth,
+             uint64_t count);
+
+  int32_t                   count_threads_;
+  std::unique_ptr<Entry[]>  entries_;
+  size_t                    mask_;
+  std::atomic<uint64_t>     count_hits_;
+};
+
+#endif  // REVERSI_PERFT_H__
@@ -1,23 +1,17 @@
 // Copyright 2016 iRonhead
-#include <algorithm>
 #include <cassert>
-#include <cmath>
-#include <cstdlib>
 #include <iostream>
-#include <memory>
+#include <new>
 #include <string>
 #include <vector>
+#include "bitboard.hpp"
+#include "board.hpp"
+#include "endgame.hpp"
 #include "reversi.hpp"
+#include "zobrist.hpp"
 
 using std::cout;
-using std::dynamic_pointer_cast;
 using std::endl;
-using std::max_element;
-using std::log;
-using std::rand;
-using std::shared_ptr;
-using std::sort;
-using std::sqrt;
 using std::string;
 using std::vector;
 
@@ -30,10 +24,151 @@ bool ReversiState::IsInvalidPosition(int32_t x, int32_t y) {
   return x < 0 || x > 7 || y < 0 || y > 7;
 }
 
+//------------------------------------------------------------------------------
+ReversiState::Player ReversiState::Playout(
+    uint64_t blacks, uint64_t whites, Player player, Random* random) {
+  auto self = (player == Player::kBlack) ? blacks : whites;
+  auto opponent = (player == Player::kBlack) ? whites : blacks;
+  auto passed = false;
+
+  while (true) {
+    auto moves = Bitboard::ValidMoves(self, opponent);
+
+    if (moves == 0) {
+      // The game ends when both players have to pass.
+      if (passed) { break; }
+
+      passed = true;
+    } else {
+      auto move = Bitboard::NthBit(
+        moves, random->Below(Bitboard::Count(moves)));
+      auto flips = Bitboard::Flips(self, opponent, move);
+
+      self ^= flips | move;
+      opponent ^= flips;
+
+      passed = false;
+    }
+
+    auto temp = self;
+
+    self = opponent;
+    opponent = temp;
+
+    player = (player == Player::kBlack) ? Player::kWhite : Player::kBlack;
+  }
+
+  blacks = (player == Player::kBlack) ? self : opponent;
+  whites = (player == Player::kBlack) ? opponent : self;
+
+  return ReversiState::WinnerOf(blacks, whites);
+}
+
+//------------------------------------------------------------------------------
+void ReversiState::Playouts(const ReversiBoard* boards, int32_t count,
+                            Random* random, int32_t* winners) {
+  const auto kLanes = Bitboard::kLanes;
+
+  // An idle lane is an empty board, it has no move and is skipped.
+  uint64_t self[kLanes] = {0}, opponent[kLanes] = {0};
+  uint64_t moves[kLanes], flips[kLanes];
+  int32_t games[kLanes], players[kLanes];
+  bool passed[kLanes], ended[kLanes];
+
+  int32_t count_started = 0, count_busy = 0;
+
+  auto fn_start = [&](int32_t lane) {
+    games[lane] = -1;
+
+    if (count_started == count) {
+      self[lane] = opponent[lane] = 0;
+
+      return;
+    }
+
+    const auto& board = boards[count_started];
+    const auto black = (board.player == Player::kBlack);
+
+    self[lane] = black ? board.blacks : board.whites;
+    opponent[lane] = black ? board.whites : board.blacks;
+    players[lane] = board.player;
+    passed[lane] = false;
+    games[lane] = count_started++;
+
+    count_busy += 1;
+  };
+
+  for (auto lane = 0; lane < kLanes; ++lane) {
+    fn_start(lane);
+  }
+
+  while (count_busy > 0) {
+    Bitboard::ValidMoves4(self, opponent, moves);
+
+    // Draw the moves, the random numbers can not be vectorized.
+    for (auto lane = 0; lane < kLanes; ++lane) {
+      ended[lane] = false;
+
+      if (moves[lane] != 0) {
+        moves[lane] = Bitboard::NthBit(
+          moves[lane], random->Below(Bitboard::Count(moves[lane])));
+
+        passed[lane] = false;
+      } else if (games[lane] >= 0) {
+        // The game ends when both players have to pass.
+        ended[lane] = passed[lane];
+        passed[lane] = true;
+      }
+    }
+
+    Bitboard::Flips4(self, opponent, moves, flips);
+
+    for (auto lane = 0; lane < kLanes; ++lane) {
+      if (games[lane] < 0) { continue; }
+
+      if (ended[lane]) {
+        const auto black = (players[lane] == Player::kBlack);
+
+        winners[games[lane]] = ReversiState::WinnerOf(
+          black ? self[lane] : opponent[lane],
+          black ? opponent[lane] : self[lane]);
+
+        count_busy -= 1;
+
+        fn_start(lane);
+
+        continue;
+      }
+
+      const auto temp = self[lane] ^ flips[lane] ^ moves[lane];
+
+      self[lane] = opponent[lane] ^ flips[lane];
+      opponent[lane] = temp;
+      players[lane] =
+        (players[lane] == Player::kBlack) ? Player::kWhite : Player::kBlack;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+ReversiState::Player ReversiState::WinnerOf(uint64_t blacks, uint64_t whites) {
+  auto blacks_count = Bitboard::Count(blacks);
+  auto whites_count = Bitboard::Count(whites);
+
+  if (blacks_count == whites_count) {
+    return Player::kDraw;
+  } else if (blacks_count > whites_count) {
+    return Player::kBlack;
+  } else {
+    return Player::kWhite;
+  }
+}
+
 //------------------------------------------------------------------------------
 ReversiState::ReversiState() :
     blacks_(0x0000001008000000), whites_(0x0000000810000000),
     player_(Player::kBlack) {
+  this->hash_ = Zobrist::Hash(this->blacks_, this->whites_, this->player_);
 }
 
 //------------------------------------------------------------------------------
@@ -53,6 +188,26 @@ ReversiState::ReversiState(const char* stones, Player player) :
       f <<= 1;
     }
   }
+
+  this->hash_ = Zobrist::Hash(this->blacks_, this->whites_, this->player_);
+}
+
+//------------------------------------------------------------------------------
+ReversiState::ReversiState(const ReversiBoard& board) :
+    blacks_(board.blacks), whites_(board.whites),
+    player_(static_cast<Player>(board.player)) {
+  this->hash_ = Zobrist::Hash(this->blacks_, this->whites_, this->player_);
+}
+
+//------------------------------------------------------------------------------
+ReversiBoard ReversiState::ToBoard() const {
+  ReversiBoard board;
+
+  board.blacks = this->blacks_;
+  board.whites = this->whites_;
+  board.player = static_cast<uint8_t>(this->player_);
+
+  return board;
 }
 
 //------------------------------------------------------------------------------
@@ -70,125 +225,115 @@ bool ReversiState::IsNormal() {
 //------------------------------------------------------------------------------
 bool ReversiState::IsEnd() {
   if (this->type_ == State::Type::kUnknown) {
-    auto moves = this->EnumValidMoves(ReversiState::Player::kBlack);
+    auto moves = this->ValidMovesMask(ReversiState::Player::kBlack);
 
-    if (moves.empty()) {
-      moves = this->EnumValidMoves(ReversiState::Player::kWhite);
+    if (moves == 0) {
+      moves = this->ValidMovesMask(ReversiState::Player::kWhite);
     }
 
     this->type_ =
-      moves.empty() ? State::Type::kEnd : State::Type::kNormal;
+      moves == 0 ? State::Type::kEnd : State::Type::kNormal;
   }
 
   return this->type_ == State::Type::kEnd;
 }
 
 //------------------------------------------------------------------------------
-State* ReversiState::Clone() const {
-  ReversiState* state = new ReversiState();
+bool ReversiState::IsSame(const State& that) const {
+  auto other = dynamic_cast<const ReversiState*>(&that);
+
+  return other != nullptr && *this == *other;
+}
+
+//------------------------------------------------------------------------------
+uint64_t ReversiState::Hash() const {
+  return this->hash_;
+}
+
+//------------------------------------------------------------------------------
+State* ReversiState::Clone(Arena* arena) const {
+  ReversiState* state = (arena == nullptr)
+    ? new ReversiState()
+    : new (arena->Allocate<ReversiState>()) ReversiState();
 
   state->blacks_ = this->blacks_;
   state->whites_ = this->whites_;
   state->player_ = this->player_;
+  state->hash_ = this->hash_;
 
   return state;
 }
 
 //------------------------------------------------------------------------------
-State* ReversiState::Expand() {
+int32_t ReversiState::Expand(Arena* arena, State** children) {
   // Expand only when this is normal (not an end).
   assert(this->IsNormal());
 
-  // Expand only when there are no children.
-  assert(this->children_.empty());
+  auto moves = this->ValidMovesMask(this->player_);
 
-  auto moves = this->EnumValidMoves(this->player_);
-
-  if (moves.empty()) {
+  if (moves == 0) {
     // This state is not an end and there is no move for this->player_.
     // The player of this state should be flipped then.
-    auto state = dynamic_cast<ReversiState*>(this->Clone());
-
-    state->parent_ = this;
+    auto state = static_cast<ReversiState*>(this->Clone(arena));
 
     state->MoveAt(-1, -1);
 
-    this->children_.emplace_back(state);
-  } else {
-    for (auto move : moves) {
-      auto state = dynamic_cast<ReversiState*>(this->Clone());
-
-      state->parent_ = this;
+    children[0] = state;
 
-      state->MoveAt(move.x, move.y);
-
-      this->children_.emplace_back(state);
-    }
+    return 1;
   }
 
-  return this->children_.front();
-}
-
-//------------------------------------------------------------------------------
-int32_t ReversiState::Simulate() {
-  shared_ptr<State> state_clone(this->Clone());
-  auto state = dynamic_pointer_cast<ReversiState>(state_clone);
+  auto count = 0;
 
-  while (state->IsNormal()) {
-    auto moves = state->EnumValidMoves(state->player_);
+  for (; moves != 0; moves &= moves - 1) {
+    auto index = Bitboard::IndexOfLowest(moves);
+    auto state = static_cast<ReversiState*>(this->Clone(arena));
 
-    if (moves.empty()) {
-      state->MoveAt(-1, -1);
-    } else {
-      auto move = moves[rand() % moves.size()];
+    state->MoveAt(index % 8, index / 8);
 
-      state->MoveAt(move.x, move.y);
-    }
+    children[count++] = state;
   }
 
-  return state->Winner();
+  return count;
 }
 
 //------------------------------------------------------------------------------
-void ReversiState::Backpropagate(int32_t winner) {
-  this->count_visits_ += 1.0f;
-  this->count_wins_ += (this->player_ == winner ? 0.0f : 1.0f);
-
-  if (this->parent_ != nullptr) {
-    auto parent = dynamic_cast<ReversiState*>(this->parent_);
+int32_t ReversiState::Simulate(Random* random) {
+  return ReversiState::Playout(
+    this->blacks_, this->whites_, this->player_, random);
+}
 
-    for (auto child : parent->children_) {
-      auto the_child = dynamic_cast<ReversiState*>(child);
+//------------------------------------------------------------------------------
+float ReversiState::Reward(int32_t winner) const {
+  // this->player_ did not move into this state, a draw counts as a win.
+  return this->player_ == winner ? 0.0f : 1.0f;
+}
 
-      if (the_child->count_visits_ == 0.0f) { continue; }
+//------------------------------------------------------------------------------
+int32_t ReversiState::Outcome() {
+  return ReversiGame::Outcome(this->ToBoard());
+}
 
-      float exploitation = the_child->count_wins_ / the_child->count_visits_;
+//------------------------------------------------------------------------------
+bool ReversiState::Solve(
+    int32_t depth, Arena* arena, State** best, int32_t* score) const {
+  ReversiBoard child;
 
-      float exploration = sqrt(
-        2.0f * log(parent->count_visits_ + 1.0f) / the_child->count_visits_);
+  if (!ReversiGame::Solve(this->ToBoard(), depth, arena, &child, score)) {
+    return false;
+  }
 
-      the_child->value_ = exploitation + exploration;
-    }
+  *best = ReversiState(child).Clone(arena);
 
-    parent->Backpropagate(winner);
-  }
+  return true;
 }
 
 //------------------------------------------------------------------------------
 void ReversiState::Inspect() const {
-  auto moves = this->EnumValidMoves(this->player_);
-
-  sort(
-    moves.begin(),
-    moves.end(),
-    [](const ReversiState::Move& a, const ReversiState::Move& b) {
-      return a.y == b.y ? a.x <= b.x : a.y < b.y;
-    });
-
   const auto blacks = this->blacks_;
   const auto whites = this->whites_;
+  const auto moves = this->ValidMovesMask(this->player_);
 
-  auto move = moves.begin();
   auto f = 1ull;
 
   cout << "   0 1 2 3 4 5 6 7 " << endl;
@@ -204,8 +349,7 @@ void ReversiState::Inspect() const {
       } else if ((whites & f) != 0) {
         cout << "\u25cb\u2502";
       } else {
-        if (move != moves.end() && move->x == x && move->y == y) {
-          ++move;
+        if ((moves & f) != 0) {
           cout << "\033[1;31m*\033[0m\u2502";
         } else {
           cout << " \u2502";
@@ -231,48 +375,6 @@ void ReversiState::Inspect() const {
   cout << endl;
 }
 
-//------------------------------------------------------------------------------
-void ReversiState::InspectValue() const {
-  this->Inspect();
-
-  auto visited_max = max_element(
-    this->children_.begin(),
-    this->children_.end(),
-    [](const State* s, const State* t) {
-      auto a = dynamic_cast<const ReversiState*>(s);
-      auto b = dynamic_cast<const ReversiState*>(t);
-      return a->count_visits_ < b->count_visits_;
-    });
-
-  auto value_max = max_element(
-    this->children_.begin(),
-    this->children_.end(),
-    [](const State* s, const State* t) {
-      auto a = dynamic_cast<const ReversiState*>(s);
-      auto b = dynamic_cast<const ReversiState*>(t);
-      return a->value_ < b->value_;
-    });
-
-  for (auto temp : this->children_) {
-    auto child = dynamic_cast<ReversiState*>(temp);
-
-    cout << endl;
-
-    if (child == *visited_max) {
-      cout << "\033[1;31m";
-    } else if (child == *value_max) {
-      cout << "\033[1;36m";
-    } else {
-      cout << "\033[37m";
-    }
-
-    cout << "visits: " << child->count_visits_ << endl;
-    cout << "value:  " << child->value_ << endl;
-
-    cout << "\033[0m";
-  }
-}
-
 //------------------------------------------------------------------------------
 bool ReversiState::operator==(const ReversiState& that) const {
   return
@@ -281,6 +383,17 @@ bool ReversiState::operator==(const ReversiState& that) const {
     this->player_ == that.player_;
 }
 
+//------------------------------------------------------------------------------
+ReversiState ReversiState::Canonical() const {
+  ReversiState state(*this);
+
+  Bitboard::Canonicalize(&state.blacks_, &state.whites_);
+
+  state.hash_ = Zobrist::Hash(state.blacks_, state.whites_, state.player_);
+
+  return state;
+}
+
 //------------------------------------------------------------------------------
 bool ReversiState::IsEmptyAt(int32_t x, int32_t y) const {
   const auto f = (1ull << (8 * y + x));
@@ -340,6 +453,7 @@ void ReversiState::PutBlackAt(int32_t x, int32_t y) {
 
   this->blacks_ |= f;
   this->whites_ &= ~f;
+  this->hash_ = Zobrist::Hash(this->blacks_, this->whites_, this->player_);
 }
 
 //------------------------------------------------------------------------------
@@ -348,6 +462,7 @@ void ReversiState::PutWhiteAt(int32_t x, int32_t y) {
 
   this->blacks_ &= ~f;
   this->whites_ |= f;
+  this->hash_ = Zobrist::Hash(this->blacks_, this->whites_, this->player_);
 }
 
 //------------------------------------------------------------------------------
@@ -361,6 +476,8 @@ void ReversiState::FlipAt(int32_t x, int32_t y) {
     this->blacks_ |= f;
     this->whites_ &= ~f;
   }
+
+  this->hash_ ^= Zobrist::Flips(f & (this->blacks_ | this->whites_));
 }
 
 //------------------------------------------------------------------------------
@@ -370,88 +487,45 @@ void ReversiState::MoveAt(int32_t x, int32_t y) {
   } else {
     assert(this->IsEmptyAt(x, y));
 
-    bool moved = false;
-
-    auto fn_is_same = (this->player_ == Player::kBlack)
-      ? &ReversiState::IsBlackAt : &ReversiState::IsWhiteAt;
-    auto fn_is_diff = (this->player_ == Player::kBlack)
-      ? &ReversiState::IsWhiteAt : &ReversiState::IsBlackAt;
-
-    int32_t u, v, du, dv;
-
-    for (auto i = 0; i < 8; ++i) {
-      du = ReversiState::kDirectionsX[i];
-      dv = ReversiState::kDirectionsY[i];
-
-      u = x + du;
-      v = y + dv;
-
-      while ((this->*fn_is_diff)(u, v)) {
-        u += du;
-        v += dv;
+    const auto move = (1ull << (8 * y + x));
 
-        if (ReversiState::IsInvalidPosition(u, v)) { break; }
-        if (this->IsEmptyAt(u, v)) { break; }
+    uint64_t flips;
 
-        if ((this->*fn_is_same)(u, v)) {
-          while (true) {
-            u -= du;
-            v -= dv;
-
-            if (u == x && v == y) { break; }
-
-            this->FlipAt(u, v);
-          }
+    if (this->player_ == ReversiState::Player::kBlack) {
+      flips = Bitboard::Flips(this->blacks_, this->whites_, move);
 
-          moved = true;
+      this->blacks_ ^= flips | move;
+      this->whites_ ^= flips;
+      this->hash_ ^= Zobrist::Stones(move, 0);
+    } else {
+      flips = Bitboard::Flips(this->whites_, this->blacks_, move);
 
-          break;
-        }
-      }
+      this->whites_ ^= flips | move;
+      this->blacks_ ^= flips;
+      this->hash_ ^= Zobrist::Stones(move, 1);
     }
 
-    if (this->player_ == ReversiState::Player::kBlack) {
-      this->PutBlackAt(x, y);
-    } else {
-      this->PutWhiteAt(x, y);
-    }
+    this->hash_ ^= Zobrist::Flips(flips);
 
     this->type_ = State::Type::kUnknown;
 
-    assert(moved);
+    assert(flips != 0);
   }
 
   this->player_ = (this->player_ == ReversiState::Player::kBlack
                   ? ReversiState::Player::kWhite
                   : ReversiState::Player::kBlack);
+  this->hash_ ^= Zobrist::Turn();
 }
 
 //------------------------------------------------------------------------------
 int32_t ReversiState::BlacksCount() const {
-  auto temp = this->blacks_;
-  auto count = 0;
-
-  while (temp != 0) {
-    if ((temp & 1) != 0) { ++count; }
-
-    temp >>= 1;
-  }
-
-  return count;
+  return Bitboard::Count(this->blacks_);
 }
 
 //------------------------------------------------------------------------------
 int32_t ReversiState::WhitesCount() const {
-  auto temp = this->whites_;
-  auto count = 0;
-
-  while (temp != 0) {
-    if ((temp & 1) != 0) { ++count; }
-
-    temp >>= 1;
-  }
-
-  return count;
+  return Bitboard::Count(this->whites_);
 }
 
 //------------------------------------------------------------------------------
@@ -477,11 +551,18 @@ ReversiState::Player ReversiState::Winner() const {
 vector<ReversiState::Move> ReversiState::EnumValidMoves(Player c) const {
   vector<ReversiState::Move> moves;
 
-  for (auto y = 0; y < 8; ++y) {
-    for (auto x = 0; x < 8; ++x) {
-      if (this->IsValidMoveAt(x, y, c)) { moves.emplace_back(x, y); }
-    }
+  for (auto mask = this->ValidMovesMask(c); mask != 0; mask &= mask - 1) {
+    auto index = Bitboard::IndexOfLowest(mask);
+
+    moves.emplace_back(index % 8, index / 8);
   }
 
   return moves;
 }
+
+//------------------------------------------------------------------------------
+uint64_t ReversiState::ValidMovesMask(Player c) const {
+  return (c == Player::kBlack)
+    ? Bitboard::ValidMoves(this->blacks_, this->whites_)
+    : Bitboard::ValidMoves(this->whites_, this->blacks_);
+}
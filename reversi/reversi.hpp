@@ -6,6 +6,8 @@
 #include <vector>
 #include "../uct/state.hpp"
 
+struct ReversiBoard;
+
 class ReversiState : public State {
  public:
   enum Player { kBlack, kWhite, kDraw };
@@ -25,6 +27,18 @@ class ReversiState : public State {
   // Check if x & y is on the board.
   static bool IsInvalidPosition(int32_t x, int32_t y);
 
+  // Play random moves from (blacks, whites, player) until the game ends and
+  // return the winner. The whole game stays in registers, no heap allocation.
+  static Player Playout(
+    uint64_t blacks, uint64_t whites, Player player, Random* random);
+
+  // Playout of each of count boards into winners, boards may repeat to play
+  // one board many times. Bitboard::kLanes games are played in lockstep
+  // with Bitboard::ValidMoves4 and Bitboard::Flips4, a lane whose game has
+  // ended takes the next board while the others go on.
+  static void Playouts(const ReversiBoard* boards, int32_t count,
+                       Random* random, int32_t* winners);
+
   // Default, the first move is black.
   // "        "
   // "        "
@@ -49,20 +63,38 @@ class ReversiState : public State {
   //   Player::kBlack);
   // equals to default constructor.
   ReversiState(const char* stones, Player player);
+
+  // Construct from / convert to the packed board of ReversiGame.
+  explicit ReversiState(const ReversiBoard& board);
+  ReversiBoard ToBoard() const;
+
   ~ReversiState() override;
 
   bool IsNormal() override;
   bool IsEnd() override;
-  State* Clone() const override;
-  State* Expand() override;
-  int32_t Simulate() override;
-  void Backpropagate(int32_t winner) override;
+  bool IsSame(const State& that) const override;
+  uint64_t Hash() const override;
+  State* Clone(Arena* arena = nullptr) const override;
+  int32_t Expand(Arena* arena, State** children) override;
+  int32_t Simulate(Random* random) override;
+  float Reward(int32_t winner) const override;
+
+  // A draw is a draw here, unlike in Reward.
+  int32_t Outcome() override;
+
+  // Solved by the EndgameSolver of the calling thread, score is the final
+  // disc difference. depth is the number of empty squares.
+  bool Solve(int32_t depth, Arena* arena, State** best,
+             int32_t* score) const override;
   void Inspect() const override;
-  void InspectValue() const override;
 
   // Compare 2 ReversiStates with their stones and current player.
   bool operator==(const ReversiState& that) const;
 
+  // The same state for the least of the 8 symmetric images of the board,
+  // see Bitboard::Canonicalize. Symmetric states have equal canonical ones.
+  ReversiState Canonical() const;
+
   bool IsEmptyAt(int32_t x, int32_t y) const;
   bool IsBlackAt(int32_t x, int32_t y) const;
   bool IsWhiteAt(int32_t x, int32_t y) const;
@@ -77,13 +109,22 @@ class ReversiState : public State {
   Player Winner() const;
   std::vector<Move> EnumValidMoves(Player c) const;
 
+  // All valid moves of player c as a bit mask, bit (8 * y + x) is Move(x, y).
+  uint64_t ValidMovesMask(Player c) const;
+
  private:
   static const int32_t  kDirectionsX[8];
   static const int32_t  kDirectionsY[8];
 
+  // The winner by the count of stones.
+  static Player WinnerOf(uint64_t blacks, uint64_t whites);
+
   uint64_t  blacks_;
   uint64_t  whites_;
   Player    player_;
+
+  // Zobrist hash of the 3 above, kept up to date by MoveAt.
+  uint64_t  hash_;
 };
 
 #endif  // REVERSI_REVERSI_H__
@@ -0,0 +1,219 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <utility>
+#include "service.hpp"
+
+using std::future;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::promise;
+using std::unique_lock;
+
+namespace {
+//------------------------------------------------------------------------------
+double MillisecondsOf(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+//------------------------------------------------------------------------------
+SearchService::SearchService(const UctOptions& options, int32_t count_threads)
+    : options_(options), count_submitted_(0), stop_(false) {
+  // A slice is a search which goes on with the tree of the last one.
+  this->options_.count_round = kSliceRounds;
+  this->options_.time_limit = 0;
+  this->options_.count_threads = 1;
+  this->options_.reuse_tree = true;
+  this->options_.stats_path.clear();
+
+  for (auto i = 0; i < std::max(count_threads, 1); ++i) {
+    this->threads_.emplace_back(&SearchService::Work, this);
+  }
+}
+
+//------------------------------------------------------------------------------
+SearchService::~SearchService() {
+  {
+    lock_guard<mutex> lock(this->guard_);
+
+    this->stop_ = true;
+    this->condition_.notify_all();
+  }
+
+  for (auto& thread : this->threads_) {
+    thread.join();
+  }
+}
+
+//------------------------------------------------------------------------------
+void SearchService::Submit(const SearchRequest& request, Callback callback) {
+  auto job = new Job();
+
+  job->request = request;
+  job->callback = std::move(callback);
+  job->submitted = Clock::now();
+  job->deadline = request.deadline > 0
+    ? job->submitted + std::chrono::milliseconds(request.deadline)
+    : Clock::time_point::max();
+
+  lock_guard<mutex> lock(this->guard_);
+
+  job->sequence = this->count_submitted_++;
+
+  this->jobs_.push(job);
+  this->condition_.notify_one();
+}
+
+//------------------------------------------------------------------------------
+future<SearchResult> SearchService::Submit(const SearchRequest& request) {
+  auto result = make_shared<promise<SearchResult>>();
+
+  this->Submit(request, [result](const SearchResult& that) {
+    result->set_value(that);
+  });
+
+  return result->get_future();
+}
+
+//------------------------------------------------------------------------------
+bool SearchService::Later::operator()(const Job* a, const Job* b) const {
+  if (a->deadline != b->deadline) { return a->deadline > b->deadline; }
+
+  return a->sequence > b->sequence;
+}
+
+//------------------------------------------------------------------------------
+void SearchService::Work() {
+  unique_lock<mutex> lock(this->guard_);
+
+  while (true) {
+    this->condition_.wait(lock, [this]() {
+      return !this->jobs_.empty() || this->stop_;
+    });
+
+    // A job in the slice of another thread is queued again by that thread.
+    if (this->jobs_.empty()) { break; }
+
+    auto job = this->jobs_.top();
+
+    this->jobs_.pop();
+
+    if (!job->uct && !this->spare_ucts_.empty()) {
+      job->uct = std::move(this->spare_ucts_.back());
+
+      this->spare_ucts_.pop_back();
+    }
+
+    lock.unlock();
+
+    if (!job->uct) {
+      job->uct.reset(new Uct<ReversiGame>(this->options_));
+    }
+
+    const auto is_done = this->Slice(job);
+
+    if (is_done) {
+      this->Finish(job);
+
+      job->callback(job->result);
+    }
+
+    lock.lock();
+
+    if (is_done) {
+      this->spare_ucts_.push_back(std::move(job->uct));
+
+      delete job;
+    } else {
+      this->jobs_.push(job);
+      this->condition_.notify_one();
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+bool SearchService::Slice(Job* job) {
+  auto& result = job->result;
+
+  if (result.count_slices == 0) {
+    job->started = Clock::now();
+
+    result.queue_milliseconds = MillisecondsOf(job->started - job->submitted);
+
+    if (ReversiGame::IsEnd(job->request.board)) {
+      result.is_end = true;
+
+      return true;
+    }
+
+    // The Uct may be recycled from a search of the same position, which
+    // would go on with its tree.
+    job->uct->Clear();
+  }
+
+  job->uct->Search(job->request.board);
+
+  const auto& report = job->uct->GetReport();
+
+  result.count_round += report.count_round;
+  result.count_slices += 1;
+
+  if (report.is_solved) {
+    result.is_solved = true;
+    result.score = report.score;
+
+    return true;
+  }
+
+  if (report.is_proven || result.count_round >= job->request.count_round) {
+    return true;
+  }
+
+  if (Clock::now() >= job->deadline) {
+    result.is_late = true;
+
+    return true;
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void SearchService::Finish(Job* job) {
+  auto& result = job->result;
+
+  result.search_milliseconds = MillisecondsOf(Clock::now() - job->started);
+
+  if (result.is_end) {
+    result.best = job->request.board;
+
+    return;
+  }
+
+  const auto& tree = job->uct->GetTree();
+  const auto& root = tree.NodeAt(0);
+
+  // The most visited child, a solved root has one.
+  auto best = root.first_child;
+
+  for (uint32_t i = 1; i < root.count_children; ++i) {
+    if (tree.NodeAt(root.first_child + i).count_visits.load() >
+        tree.NodeAt(best).count_visits.load()) {
+      best = root.first_child + i;
+    }
+  }
+
+  const auto& node = tree.NodeAt(best);
+
+  result.best = tree.BoardAt(best);
+  result.count_root_visits = root.count_visits.load();
+
+  if (result.is_solved) {
+    result.value =
+      result.score > 0 ? 1.0f : result.score < 0 ? 0.0f : 0.5f;
+  } else {
+    result.value =
+      node.count_wins.load() / std::max(node.count_visits.load(), 1u);
+  }
+}
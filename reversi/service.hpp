@@ -0,0 +1,148 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_SERVICE_H__
+#define REVERSI_SERVICE_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../uct/uct.hpp"
+#include "board.hpp"
+
+// A search of one position on behalf of one game.
+struct SearchRequest {
+  ReversiBoard  board;
+
+  // Rounds to search, rounded up to whole slices (SearchService::
+  // kSliceRounds).
+  int32_t       count_round;
+
+  // Milliseconds from Submit by which the result is wanted, 0 for none.
+  // Once it passes, the request is answered with what it has after the
+  // slice it is in, at least one slice is always searched.
+  int32_t       deadline;
+
+  SearchRequest() : count_round(10000), deadline(0) {}
+};
+
+struct SearchResult {
+  // The position of the most visited move, the request board if is_end.
+  ReversiBoard  best;
+
+  // True if the request board is an end, nothing was searched.
+  bool          is_end;
+
+  // True if the position was solved exactly (UctOptions::solve_depth),
+  // score is then the final disc difference of the player to move.
+  bool          is_solved;
+  int32_t       score;
+
+  // Mean reward of best for the player to move.
+  float         value;
+
+  // Rounds searched, and slices they were searched in.
+  int32_t       count_round;
+  int32_t       count_slices;
+
+  // Visits of the root, count_round as nothing is carried over from other
+  // requests.
+  uint32_t      count_root_visits;
+
+  // True if the deadline cut the rounds short.
+  bool          is_late;
+
+  // From Submit to the first slice, and from the first slice to the result.
+  // The search time includes the waits between slices, when the threads
+  // serve other requests.
+  double        queue_milliseconds;
+  double        search_milliseconds;
+
+  SearchResult() : is_end(false), is_solved(false), score(0), value(0.0f),
+      count_round(0), count_slices(0), count_root_visits(0), is_late(false),
+      queue_milliseconds(0.0), search_milliseconds(0.0) {}
+};
+
+// Searches of many games on one pool of threads. Instead of a thread and a
+// blocking search per game, each request is searched in slices of
+// kSliceRounds rounds and the threads always take the slice of the request
+// with the earliest deadline (requests without one come last, all in the
+// order they were submitted). A request keeps its tree between slices, a
+// Uct with UctOptions::reuse_tree goes on with the same root.
+//
+// The Ucts are recycled from request to request, there are as many as
+// requests were ever searched at once. Each request starts with a cleared
+// tree, its result does not depend on the requests searched before.
+class SearchService {
+ public:
+  typedef std::function<void(const SearchResult&)> Callback;
+
+  // Rounds of one slice, about a millisecond of a search.
+  static const int32_t kSliceRounds = 256;
+
+ public:
+  // Search on count_threads threads, each request with options (the limits,
+  // threads, reuse_tree and pondering of options are not used).
+  SearchService(const UctOptions& options, int32_t count_threads);
+
+  // Answer all requests, then stop the threads.
+  ~SearchService();
+
+  SearchService(const SearchService&) = delete;
+  SearchService& operator=(const SearchService&) = delete;
+
+  // Queue request, callback is called with its result on one of the threads
+  // of the service.
+  void Submit(const SearchRequest& request, Callback callback);
+
+  std::future<SearchResult> Submit(const SearchRequest& request);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Job {
+    SearchRequest                       request;
+    Callback                            callback;
+    uint64_t                            sequence;
+    Clock::time_point                   submitted;
+    Clock::time_point                   deadline;
+    Clock::time_point                   started;
+    std::unique_ptr<Uct<ReversiGame>>   uct;
+    SearchResult                        result;
+  };
+
+  // Order of the queue, top is the earliest deadline, then the earliest
+  // submitted.
+  struct Later {
+    bool operator()(const Job* a, const Job* b) const;
+  };
+
+  typedef std::priority_queue<Job*, std::vector<Job*>, Later> Queue;
+
+  // Take slices until stop_ is set and nothing is queued.
+  void Work();
+
+  // Search one slice of job, return true if it is done.
+  bool Slice(Job* job);
+
+  // Fill the result of job from its tree.
+  void Finish(Job* job);
+
+  UctOptions                                      options_;
+
+  std::mutex                                      guard_;
+  std::condition_variable                         condition_;
+  Queue                                           jobs_;
+  std::vector<std::unique_ptr<Uct<ReversiGame>>>  spare_ucts_;
+  uint64_t                                        count_submitted_;
+  bool                                            stop_;
+
+  std::vector<std::thread>                        threads_;
+};
+
+#endif  // REVERSI_SERVICE_H__
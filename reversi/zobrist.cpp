@@ -0,0 +1,53 @@
+// Copyright 2016 iRonhead
+#include "zobrist.hpp"
+
+namespace {
+// SplitMix64, fixed seed so hashes are the same on every run.
+uint64_t NextKey(uint64_t* seed) {
+  uint64_t z = (*seed += 0x9e3779b97f4a7c15ull);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+  return z ^ (z >> 31);
+}
+}  // namespace
+
+uint64_t Zobrist::keys_[3][8][256];
+
+uint64_t Zobrist::turn_;
+
+const bool Zobrist::is_initialized_ = Zobrist::Initialize();
+
+//------------------------------------------------------------------------------
+bool Zobrist::Initialize() {
+  uint64_t seed = 0x2016;
+  uint64_t squares[2][64];
+
+  for (auto color = 0; color < 2; ++color) {
+    for (auto i = 0; i < 64; ++i) {
+      squares[color][i] = NextKey(&seed);
+    }
+  }
+
+  Zobrist::turn_ = NextKey(&seed);
+
+  for (auto i = 0; i < 8; ++i) {
+    for (auto byte = 0; byte < 256; ++byte) {
+      uint64_t keys[2] = {0, 0};
+
+      for (auto bit = 0; bit < 8; ++bit) {
+        if ((byte & (1 << bit)) == 0) { continue; }
+
+        keys[0] ^= squares[0][8 * i + bit];
+        keys[1] ^= squares[1][8 * i + bit];
+      }
+
+      Zobrist::keys_[0][i][byte] = keys[0];
+      Zobrist::keys_[1][i][byte] = keys[1];
+      Zobrist::keys_[2][i][byte] = keys[0] ^ keys[1];
+    }
+  }
+
+  return true;
+}
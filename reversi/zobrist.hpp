@@ -0,0 +1,68 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_ZOBRIST_H__
+#define REVERSI_ZOBRIST_H__
+
+#include <cstdint>
+#include "reversi.hpp"
+
+// Zobrist hashing of reversi positions: the hash is the xor of a random key
+// per (square, color) of every stone, and of one more key when white is to
+// move. A move changes it by the keys of the new stone, of both colors of
+// every flipped stone, and of the turn, see ReversiState::MoveAt.
+//
+// The keys are xor-ed a byte of a board at a time from tables of 256, so a
+// hash from scratch costs 16 lookups and a flip mask at most 8.
+class Zobrist {
+ public:
+  static uint64_t Hash(
+    uint64_t blacks, uint64_t whites, ReversiState::Player player);
+
+  // Keys of the stones of color (0 for black, 1 for white) on board.
+  static uint64_t Stones(uint64_t board, int32_t color);
+
+  // Keys of both colors of the stones on flips.
+  static uint64_t Flips(uint64_t flips);
+
+  // Key of white to move.
+  static uint64_t Turn();
+
+ private:
+  static bool Initialize();
+
+  // [color][byte index][byte], color 2 is both colors.
+  static uint64_t keys_[3][8][256];
+  static uint64_t turn_;
+  static const bool is_initialized_;
+};
+
+//------------------------------------------------------------------------------
+inline uint64_t Zobrist::Stones(uint64_t board, int32_t color) {
+  uint64_t hash = 0;
+
+  for (auto i = 0; board != 0; ++i, board >>= 8) {
+    hash ^= Zobrist::keys_[color][i][board & 0xff];
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Zobrist::Flips(uint64_t flips) {
+  return Zobrist::Stones(flips, 2);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Zobrist::Turn() {
+  return Zobrist::turn_;
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Zobrist::Hash(
+    uint64_t blacks, uint64_t whites, ReversiState::Player player) {
+  return
+    Zobrist::Stones(blacks, 0) ^
+    Zobrist::Stones(whites, 1) ^
+    (player == ReversiState::Player::kWhite ? Zobrist::turn_ : 0);
+}
+
+#endif  // REVERSI_ZOBRIST_H__
@@ -0,0 +1,121 @@
+// Copyright 2016 iRonhead
+#include <cstdio>
+#include <vector>
+
+#include "./catch/include/catch.hpp"
+#include "../reversi/bitboard.hpp"
+#include "../reversi/board.hpp"
+#include "../reversi/book.hpp"
+#include "../reversi/reversi.hpp"
+
+using std::fclose;
+using std::fopen;
+using std::fputs;
+using std::remove;
+using std::vector;
+
+TEST_CASE("OpeningBook", "[OpeningBook]") {
+  const char* path = "test_opening.book";
+
+  ReversiState root;
+  ReversiState root_f5(root), root_f5_d6(root), root_f5_f6(root);
+
+  root_f5.MoveAt(4, 2);
+  root_f5_d6.MoveAt(4, 2);
+  root_f5_d6.MoveAt(3, 2);
+  root_f5_f6.MoveAt(4, 2);
+  root_f5_f6.MoveAt(5, 2);
+
+  vector<OpeningBook::Entry> entries;
+
+  entries.push_back(OpeningBook::EntryOf(
+    root.ToBoard(), root_f5.ToBoard(), 4000, 0.5f));
+  entries.push_back(OpeningBook::EntryOf(
+    root_f5.ToBoard(), root_f5_f6.ToBoard(), 500, 0.4f));
+  entries.push_back(OpeningBook::EntryOf(
+    root_f5.ToBoard(), root_f5_d6.ToBoard(), 3000, 0.6f));
+
+  REQUIRE(OpeningBook::Write(path, entries));
+
+  OpeningBook book;
+
+  REQUIRE(book.Open(path));
+  REQUIRE(book.IsOpen());
+  REQUIRE(book.CountEntries() == 3);
+
+  ReversiBoard move;
+
+  SECTION("Most Visited Move") {
+    REQUIRE(book.Probe(root_f5.ToBoard(), 0, &move));
+    REQUIRE(ReversiState(move) == root_f5_d6);
+
+    REQUIRE(book.Probe(root.ToBoard(), 4000, &move));
+    REQUIRE(ReversiState(move) == root_f5);
+
+    REQUIRE_FALSE(book.Probe(root.ToBoard(), 4001, &move));
+    REQUIRE_FALSE(book.Probe(root_f5_d6.ToBoard(), 0, &move));
+  }
+
+  SECTION("Symmetric Positions") {
+    // Every first move is the same, the reply is the image of d6.
+    for (const auto& first : root.EnumValidMoves(root.CurrentPlayer())) {
+      ReversiState state(root);
+
+      state.MoveAt(first.x, first.y);
+
+      REQUIRE(book.Probe(state.ToBoard(), 0, &move));
+
+      ReversiState reply(move);
+
+      REQUIRE(reply.Canonical() == root_f5_d6.Canonical());
+      REQUIRE(reply.BlacksCount() + reply.WhitesCount() == 6);
+    }
+  }
+
+  SECTION("Pass") {
+    // White has no move.
+    ReversiState state(
+      " oxxxxxx"
+      "        "
+      "        "
+      "        "
+      "        "
+      "        "
+      "        "
+      "        ",
+      ReversiState::Player::kWhite);
+
+    REQUIRE(state.EnumValidMoves(ReversiState::Player::kWhite).empty());
+    REQUIRE(!state.IsEnd());
+
+    ReversiState pass(state);
+
+    pass.MoveAt(-1, -1);
+
+    entries.push_back(OpeningBook::EntryOf(
+      state.ToBoard(), pass.ToBoard(), 10, 0.0f));
+
+    REQUIRE(OpeningBook::Write(path, entries));
+    REQUIRE(book.Open(path));
+    REQUIRE(book.CountEntries() == 4);
+    REQUIRE(book.Probe(state.ToBoard(), 0, &move));
+    REQUIRE(ReversiState(move) == pass);
+  }
+
+  SECTION("Not a Book") {
+    auto file = fopen(path, "wb");
+
+    fputs("not an opening book, not at all", file);
+    fclose(file);
+
+    REQUIRE_FALSE(book.Open(path));
+    REQUIRE_FALSE(book.IsOpen());
+    REQUIRE_FALSE(book.Probe(root.ToBoard(), 0, &move));
+  }
+
+  book.Close();
+
+  REQUIRE_FALSE(book.IsOpen());
+
+  remove(path);
+}
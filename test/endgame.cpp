@@ -0,0 +1,122 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+
+#include "./catch/include/catch.hpp"
+#include "../reversi/bitboard.hpp"
+#include "../reversi/endgame.hpp"
+
+using std::max;
+using std::rand;
+using std::srand;
+using std::swap;
+
+// Plain minimax, the reference of the solver.
+static int32_t Minimax(uint64_t self, uint64_t opponent, bool passed) {
+  auto moves = Bitboard::ValidMoves(self, opponent);
+
+  if (moves == 0) {
+    if (passed) { return EndgameSolver::FinalScore(self, opponent); }
+
+    return -Minimax(opponent, self, true);
+  }
+
+  int32_t best = -EndgameSolver::kMaxScore;
+
+  for (; moves != 0; moves &= moves - 1) {
+    const auto move = moves & (~moves + 1);
+    const auto flips = Bitboard::Flips(self, opponent, move);
+
+    best = max(best, -Minimax(opponent ^ flips, self ^ flips ^ move, false));
+  }
+
+  return best;
+}
+
+// Play random moves from the initial position until count_empties squares are
+// left. Return false if the game ends before.
+static bool RandomEndgame(
+    int32_t count_empties, uint64_t* self, uint64_t* opponent) {
+  *self = 0x0000001008000000ull;
+  *opponent = 0x0000000810000000ull;
+
+  while (Bitboard::Count(~(*self | *opponent)) > count_empties) {
+    const auto moves = Bitboard::ValidMoves(*self, *opponent);
+
+    if (moves != 0) {
+      const auto move =
+        Bitboard::NthBit(moves, rand() % Bitboard::Count(moves));
+      const auto flips = Bitboard::Flips(*self, *opponent, move);
+
+      *self ^= flips | move;
+      *opponent ^= flips;
+    } else if (Bitboard::ValidMoves(*opponent, *self) == 0) {
+      return false;
+    }
+
+    swap(*self, *opponent);
+  }
+
+  return true;
+}
+
+TEST_CASE("EndgameSolver", "[Endgame]") {
+  SECTION("Final Score") {
+    // Empties go to the winner.
+    REQUIRE(EndgameSolver::FinalScore(0xffull, 0xff00ull) == 0);
+    REQUIRE(EndgameSolver::FinalScore(0xffffull, 0x10000ull) == 62);
+    REQUIRE(EndgameSolver::FinalScore(0x10000ull, 0xffffull) == -62);
+    REQUIRE(EndgameSolver::FinalScore(~0ull, 0) == 64);
+  }
+
+  SECTION("Same as Minimax") {
+    EndgameSolver solver(1 << 16);
+
+    srand(15);
+
+    // Up to 4 empties are solved by the last routines, up to 7 without the
+    // table.
+    for (auto count_empties = 0; count_empties <= 10; ++count_empties) {
+      for (auto i = 0; i < 20; ++i) {
+        uint64_t self, opponent, move;
+
+        if (!RandomEndgame(count_empties, &self, &opponent)) { continue; }
+
+        const auto score = solver.Solve(self, opponent, &move);
+
+        REQUIRE(score == Minimax(self, opponent, false));
+
+        if (Bitboard::ValidMoves(self, opponent) == 0) {
+          REQUIRE(move == 0);
+          continue;
+        }
+
+        const auto flips = Bitboard::Flips(self, opponent, move);
+
+        REQUIRE(flips != 0);
+        REQUIRE(-Minimax(opponent ^ flips, self ^ flips ^ move, false) ==
+                score);
+      }
+    }
+  }
+
+  SECTION("Solved Again from the Table") {
+    EndgameSolver solver;
+
+    uint64_t self, opponent, move;
+
+    srand(12);
+
+    while (!RandomEndgame(12, &self, &opponent)) {}
+
+    const auto score = solver.Solve(self, opponent, &move);
+    const auto count_nodes = solver.CountNodes();
+
+    uint64_t move_again;
+
+    REQUIRE(solver.Solve(self, opponent, &move_again) == score);
+    REQUIRE(move_again == move);
+    REQUIRE(solver.CountNodes() - count_nodes < count_nodes / 10);
+  }
+}
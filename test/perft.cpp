@@ -0,0 +1,122 @@
+// Copyright 2016 iRonhead
+#include <cstdint>
+#include <vector>
+
+#include "./catch/include/catch.hpp"
+#include "../reversi/perft.hpp"
+#include "../reversi/reversi.hpp"
+
+using std::vector;
+
+namespace {
+//------------------------------------------------------------------------------
+// Paths by EnumValidMoves and MoveAt.
+uint64_t Paths(ReversiState state, int32_t depth) {
+  if (depth == 0) { return 1; }
+
+  auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+  if (moves.empty()) {
+    if (state.IsEnd()) { return 1; }
+
+    state.MoveAt(-1, -1);
+
+    return Paths(state, depth - 1);
+  }
+
+  uint64_t count = 0;
+
+  for (const auto& move : moves) {
+    ReversiState child(state);
+
+    child.MoveAt(move.x, move.y);
+
+    count += Paths(child, depth - 1);
+  }
+
+  return count;
+}
+}  // namespace
+
+TEST_CASE("Perft", "[Perft]") {
+  const uint64_t counts[] = {
+    1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288};
+
+  SECTION("Opening") {
+    // The small table is overwritten all the time.
+    Perft perft_one;
+    Perft perft_many(4, 1 << 12);
+
+    for (auto depth = 0; depth < 10; ++depth) {
+      REQUIRE(perft_one.Count(ReversiState(), depth) == counts[depth]);
+      REQUIRE(perft_many.Count(ReversiState(), depth) == counts[depth]);
+    }
+
+    REQUIRE(perft_one.CountHits() == 0);
+    REQUIRE(perft_many.CountHits() > 0);
+  }
+
+  SECTION("Divide") {
+    Perft perft(4);
+
+    const auto divisions = perft.Divide(ReversiState(), 6);
+
+    REQUIRE(divisions.size() == 4);
+
+    const auto moves =
+      ReversiState().EnumValidMoves(ReversiState::Player::kBlack);
+
+    // The first moves are symmetric.
+    for (size_t i = 0; i < divisions.size(); ++i) {
+      REQUIRE(divisions[i].first == moves[i]);
+      REQUIRE(divisions[i].second == counts[6] / 4);
+    }
+  }
+
+  SECTION("Passes and Ends") {
+    // Late positions of random games, where passes and ends are common.
+    Perft perft_one;
+    Perft perft_many(3, 1 << 16);
+
+    Random random(21);
+
+    for (auto game = 0; game < 20; ++game) {
+      ReversiState state;
+
+      for (auto ply = 0; !state.IsEnd(); ++ply) {
+        if (ply >= 48) {
+          REQUIRE(perft_one.Count(state, 6) == Paths(state, 6));
+          REQUIRE(perft_many.Count(state, 6) == Paths(state, 6));
+
+          // The divisions of a pass, and nothing for an end.
+          uint64_t count = 0;
+
+          for (const auto& division : perft_many.Divide(state, 3)) {
+            ReversiState child(state);
+
+            child.MoveAt(division.first.x, division.first.y);
+
+            REQUIRE(division.second == Paths(child, 2));
+
+            count += division.second;
+          }
+
+          REQUIRE(count == Paths(state, 3));
+        }
+
+        auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+        if (moves.empty()) {
+          state.MoveAt(-1, -1);
+        } else {
+          const auto& move = moves[random.Below(moves.size())];
+
+          state.MoveAt(move.x, move.y);
+        }
+      }
+
+      REQUIRE(perft_many.Count(state, 4) == 1);
+      REQUIRE(perft_many.Divide(state, 4).empty());
+    }
+  }
+}
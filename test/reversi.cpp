@@ -1,16 +1,40 @@
 // Copyright 2016 iRonhead
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <memory>
+#include <new>
 #include <vector>
 
 #include "./catch/include/catch.hpp"
+#include "../reversi/board.hpp"
 #include "../reversi/reversi.hpp"
+#include "../reversi/zobrist.hpp"
 
+using std::abs;
 using std::dynamic_pointer_cast;
+using std::rand;
 using std::shared_ptr;
 using std::sort;
+using std::srand;
 using std::vector;
 
+// Count every heap allocation of the test binary, so a test can tell if a
+// block of code allocated anything. Threads of other tests allocate too.
+static std::atomic<int64_t> count_allocations(0);
+
+void* operator new(std::size_t size) {
+  count_allocations += 1;
+
+  if (void* memory = std::malloc(size)) { return memory; }
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
 TEST_CASE("ReversiState static methods", "[ReversiState]") {
   SECTION("IsInvalidPosition") {
     REQUIRE(ReversiState::IsInvalidPosition(-1, -1));
@@ -228,6 +252,8 @@ TEST_CASE("ReversiState", "[ReversiState]") {
 }
 
 TEST_CASE("ReversiState Expand", "[ReversiState]") {
+  Arena arena;
+
   SECTION("With One New Move") {
     shared_ptr<ReversiState> state_source(new ReversiState(
       "o       "
@@ -251,8 +277,12 @@ TEST_CASE("ReversiState Expand", "[ReversiState]") {
       "        ",
       ReversiState::Player::kBlack));
 
-    auto state_expanded = dynamic_cast<ReversiState*>(state_source->Expand());
+    State* children[State::kMaxChildren];
+
+    auto count = state_source->Expand(&arena, children);
+    auto state_expanded = dynamic_cast<ReversiState*>(children[0]);
 
+    REQUIRE(count == 1);
     REQUIRE(*state_expanded == *state_target);
   }
 
@@ -279,8 +309,12 @@ TEST_CASE("ReversiState Expand", "[ReversiState]") {
       "        ",
       ReversiState::Player::kWhite));
 
-    auto state_expanded = dynamic_cast<ReversiState*>(state_source->Expand());
+    State* children[State::kMaxChildren];
+
+    auto count = state_source->Expand(&arena, children);
+    auto state_expanded = dynamic_cast<ReversiState*>(children[0]);
 
+    REQUIRE(count == 1);
     REQUIRE(*state_expanded == *state_target);
   }
 }
@@ -339,6 +373,8 @@ TEST_CASE("ReversiState Count Stones", "[ReversiState]") {
 }
 
 TEST_CASE("ReversiState Simulate", "[ReversiState]") {
+  Random random(2018);
+
   SECTION("Simulate - White Win") {
     shared_ptr<ReversiState> state(new ReversiState(
       "xooooooo"
@@ -351,7 +387,7 @@ TEST_CASE("ReversiState Simulate", "[ReversiState]") {
       "ooooooo ",
       ReversiState::Player::kBlack));
 
-    auto winner = state->Simulate();
+    auto winner = state->Simulate(&random);
 
     REQUIRE(winner == ReversiState::Player::kWhite);
   }
@@ -368,10 +404,45 @@ TEST_CASE("ReversiState Simulate", "[ReversiState]") {
       "oooooooo",
       ReversiState::Player::kBlack));
 
-    auto winner = state->Simulate();
+    auto winner = state->Simulate(&random);
 
     REQUIRE(winner == ReversiState::Player::kDraw);
   }
+
+  SECTION("Simulate - Without Heap Allocation") {
+    shared_ptr<ReversiState> state(new ReversiState());
+
+    const int64_t count_allocations_before = count_allocations;
+
+    for (auto i = 0; i < 100; ++i) {
+      state->Simulate(&random);
+    }
+
+    REQUIRE(count_allocations == count_allocations_before);
+  }
+
+  SECTION("Playout - Same Games as MoveAt") {
+    for (auto seed = 1u; seed <= 100u; ++seed) {
+      ReversiState state;
+      Random random(seed);
+
+      while (!state.IsEnd()) {
+        auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+        if (moves.empty()) {
+          state.MoveAt(-1, -1);
+        } else {
+          auto move = moves[random.Below(moves.size())];
+
+          state.MoveAt(move.x, move.y);
+        }
+      }
+
+      random.Seed(seed);
+
+      REQUIRE(ReversiState().Simulate(&random) == state.Winner());
+    }
+  }
 }
 
 TEST_CASE("ReversiState Bugs", "[ReversiState]") {
@@ -418,3 +489,490 @@ TEST_CASE("ReversiState Bugs", "[ReversiState]") {
     REQUIRE(*state_source == *state_target);
   }
 }
+
+TEST_CASE("ReversiState ValidMovesMask", "[ReversiState]") {
+  auto fn_check = [](const ReversiState& state) -> bool {
+    const ReversiState::Player players[] = {
+      ReversiState::Player::kBlack, ReversiState::Player::kWhite
+    };
+
+    for (auto c : players) {
+      auto mask = state.ValidMovesMask(c);
+
+      for (auto y = 0; y < 8; ++y) {
+        for (auto x = 0; x < 8; ++x) {
+          auto bit = (mask >> (8 * y + x)) & 1ull;
+
+          if ((bit != 0) != state.IsValidMoveAt(x, y, c)) { return false; }
+        }
+      }
+    }
+
+    return true;
+  };
+
+  SECTION("Fixed Positions") {
+    REQUIRE(fn_check(ReversiState()));
+
+    REQUIRE(fn_check(ReversiState(
+      "        "
+      "        "
+      "        "
+      "       x"
+      "        "
+      "        "
+      "       o"
+      "        ",
+      ReversiState::Player::kBlack)));
+
+    REQUIRE(fn_check(ReversiState(
+      "        "
+      "   x    "
+      "   xoo  "
+      "   xoooo"
+      "  xxxo  "
+      "    x o "
+      "   x    "
+      "  x     ",
+      ReversiState::Player::kWhite)));
+
+    REQUIRE(fn_check(ReversiState(
+      "xooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "ooooooo ",
+      ReversiState::Player::kBlack)));
+  }
+
+  SECTION("Random Games") {
+    srand(2016);
+
+    for (auto game = 0; game < 200; ++game) {
+      ReversiState state;
+
+      while (!state.IsEnd()) {
+        REQUIRE(fn_check(state));
+
+        auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+        if (moves.empty()) {
+          state.MoveAt(-1, -1);
+        } else {
+          auto move = moves[rand() % moves.size()];
+
+          state.MoveAt(move.x, move.y);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("ReversiState MoveAt Flips", "[ReversiState]") {
+  // The stone by stone walk MoveAt used before the bitboard flips.
+  auto fn_move = [](ReversiState* state, int32_t x, int32_t y) {
+    const int32_t dx[8] = {-1, +0, +1, -1, +1, -1, +0, +1};
+    const int32_t dy[8] = {-1, -1, -1, +0, +0, +1, +1, +1};
+
+    const bool black = state->CurrentPlayer() == ReversiState::Player::kBlack;
+
+    auto fn_is_same = [&](int32_t u, int32_t v) {
+      return black ? state->IsBlackAt(u, v) : state->IsWhiteAt(u, v);
+    };
+
+    auto fn_is_diff = [&](int32_t u, int32_t v) {
+      return black ? state->IsWhiteAt(u, v) : state->IsBlackAt(u, v);
+    };
+
+    for (auto i = 0; i < 8; ++i) {
+      auto u = x + dx[i];
+      auto v = y + dy[i];
+
+      while (!ReversiState::IsInvalidPosition(u, v) && fn_is_diff(u, v)) {
+        u += dx[i];
+        v += dy[i];
+
+        if (ReversiState::IsInvalidPosition(u, v)) { break; }
+
+        if (fn_is_same(u, v)) {
+          for (u -= dx[i], v -= dy[i]; u != x || v != y;) {
+            state->FlipAt(u, v);
+
+            u -= dx[i];
+            v -= dy[i];
+          }
+
+          break;
+        }
+      }
+    }
+
+    if (black) {
+      state->PutBlackAt(x, y);
+    } else {
+      state->PutWhiteAt(x, y);
+    }
+  };
+
+  srand(2017);
+
+  for (auto game = 0; game < 200; ++game) {
+    ReversiState state;
+
+    while (!state.IsEnd()) {
+      auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+      if (moves.empty()) {
+        state.MoveAt(-1, -1);
+        continue;
+      }
+
+      // Every valid move, not only the one played.
+      for (auto move : moves) {
+        ReversiState state_source(state), state_target(state);
+
+        state_source.MoveAt(move.x, move.y);
+
+        fn_move(&state_target, move.x, move.y);
+        state_target.MoveAt(-1, -1);
+
+        REQUIRE(state_source == state_target);
+      }
+
+      auto move = moves[rand() % moves.size()];
+
+      state.MoveAt(move.x, move.y);
+    }
+  }
+}
+
+TEST_CASE("ReversiState Hash", "[ReversiState]") {
+  auto fn_hash = [](const ReversiState& state) {
+    const auto board = state.ToBoard();
+
+    return Zobrist::Hash(board.blacks, board.whites, state.CurrentPlayer());
+  };
+
+  SECTION("Same as from Scratch") {
+    srand(2018);
+
+    for (auto game = 0; game < 200; ++game) {
+      ReversiState state;
+
+      while (!state.IsEnd()) {
+        REQUIRE(state.Hash() == fn_hash(state));
+        REQUIRE(state.Hash() != 0);
+
+        auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+        if (moves.empty()) {
+          state.MoveAt(-1, -1);
+        } else {
+          auto move = moves[rand() % moves.size()];
+
+          state.MoveAt(move.x, move.y);
+        }
+      }
+
+      REQUIRE(state.Hash() == fn_hash(state));
+    }
+  }
+
+  SECTION("Transpositions") {
+    // Every position 4 plies deep, the same positions are reached by many
+    // move orders and must have the same hash.
+    vector<ReversiState> states(1);
+
+    for (auto ply = 0; ply < 4; ++ply) {
+      vector<ReversiState> children;
+
+      for (const auto& state : states) {
+        for (auto move : state.EnumValidMoves(state.CurrentPlayer())) {
+          ReversiState child(state);
+
+          child.MoveAt(move.x, move.y);
+
+          children.push_back(child);
+        }
+      }
+
+      states.swap(children);
+    }
+
+    auto count_transpositions = 0;
+
+    for (size_t i = 0; i < states.size(); ++i) {
+      for (size_t j = i + 1; j < states.size(); ++j) {
+        if (states[i] == states[j]) {
+          REQUIRE(states[i].Hash() == states[j].Hash());
+
+          count_transpositions += 1;
+        } else {
+          REQUIRE(states[i].Hash() != states[j].Hash());
+        }
+      }
+    }
+
+    REQUIRE(states.size() == 244);
+    REQUIRE(count_transpositions > 0);
+
+    // The turn is part of the hash.
+    ReversiState state(states[0]);
+
+    state.MoveAt(-1, -1);
+
+    REQUIRE(state.Hash() != states[0].Hash());
+    REQUIRE(state.Hash() == fn_hash(state));
+  }
+
+  SECTION("Put & Flip") {
+    ReversiState state;
+
+    state.PutWhiteAt(0, 0);
+    state.PutBlackAt(3, 3);
+    state.FlipAt(4, 4);
+
+    shared_ptr<State> clone(state.Clone());
+
+    REQUIRE(state.Hash() == fn_hash(state));
+    REQUIRE(clone->Hash() == state.Hash());
+  }
+}
+
+TEST_CASE("Bitboard Symmetries", "[Bitboard]") {
+  // Move every stone of board one by one.
+  auto fn_map = [](uint64_t board, int32_t (*fn)(int32_t, int32_t)) {
+    uint64_t image = 0;
+
+    for (; board != 0; board &= board - 1) {
+      auto index = Bitboard::IndexOfLowest(board);
+
+      image |= 1ull << fn(index % 8, index / 8);
+    }
+
+    return image;
+  };
+
+  srand(2019);
+
+  SECTION("Transforms") {
+    for (auto i = 0; i < 1000; ++i) {
+      const uint64_t board =
+        (static_cast<uint64_t>(rand()) << 42) ^
+        (static_cast<uint64_t>(rand()) << 21) ^
+        static_cast<uint64_t>(rand());
+
+      REQUIRE(Bitboard::FlipVertical(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * (7 - y) + x; }));
+      REQUIRE(Bitboard::MirrorHorizontal(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * y + 7 - x; }));
+      REQUIRE(Bitboard::FlipDiagonal(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * x + y; }));
+      REQUIRE(Bitboard::FlipAntiDiagonal(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * (7 - x) + 7 - y; }));
+      REQUIRE(Bitboard::Rotate90(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * x + 7 - y; }));
+      REQUIRE(Bitboard::Rotate180(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * (7 - y) + 7 - x; }));
+      REQUIRE(Bitboard::Rotate270(board) == fn_map(board,
+        [](int32_t x, int32_t y) { return 8 * (7 - x) + y; }));
+
+      // All images have the same canonical form.
+      uint64_t images[Bitboard::kCountSymmetries];
+
+      Bitboard::Symmetries(board, images);
+
+      for (auto k = 0; k < Bitboard::kCountSymmetries; ++k) {
+        uint64_t blacks = images[k], whites = ~images[k], a = board, b = ~board;
+
+        REQUIRE(Bitboard::Symmetry(board, k) == images[k]);
+
+        Bitboard::Canonicalize(&blacks, &whites);
+        Bitboard::Canonicalize(&a, &b);
+
+        REQUIRE(blacks == a);
+        REQUIRE(whites == b);
+
+        // The canonical symmetry leads to the canonical form.
+        const auto canonical =
+          Bitboard::CanonicalSymmetry(images[k], ~images[k]);
+
+        REQUIRE(Bitboard::Symmetry(images[k], canonical) == a);
+        REQUIRE(Bitboard::Symmetry(~images[k], canonical) == b);
+      }
+    }
+  }
+
+  SECTION("The First Moves") {
+    // The 4 first moves are the same move.
+    ReversiState state;
+
+    vector<ReversiState> children;
+
+    for (auto move : state.EnumValidMoves(state.CurrentPlayer())) {
+      ReversiState child(state);
+
+      child.MoveAt(move.x, move.y);
+
+      children.push_back(child);
+    }
+
+    REQUIRE(children.size() == 4);
+
+    for (const auto& child : children) {
+      REQUIRE(child.Canonical() == children[0].Canonical());
+      REQUIRE(child.Canonical().Hash() ==
+              ReversiGame::Hash(children[0].ToBoard()));
+      REQUIRE(ReversiGame::Hash(child.ToBoard()) ==
+              ReversiGame::Hash(children[0].ToBoard()));
+    }
+
+    REQUIRE_FALSE(children[0] == children[1]);
+    REQUIRE(state.Canonical().Canonical() == state.Canonical());
+  }
+}
+
+TEST_CASE("Bitboard Lanes", "[Bitboard]") {
+  const auto kLanes = Bitboard::kLanes;
+
+  Random random(2019);
+
+  uint64_t self[kLanes], opponent[kLanes], moves[kLanes], flips[kLanes];
+
+  // Positions of random games, one game per lane.
+  ReversiState states[kLanes];
+
+  for (auto ply = 0; ply < 60 * 200; ++ply) {
+    for (auto lane = 0; lane < kLanes; ++lane) {
+      auto& state = states[lane];
+
+      if (state.IsEnd()) { state = ReversiState(); }
+
+      const auto player = state.CurrentPlayer();
+      const auto board = state.ToBoard();
+
+      self[lane] =
+        player == ReversiState::Player::kBlack ? board.blacks : board.whites;
+      opponent[lane] =
+        player == ReversiState::Player::kBlack ? board.whites : board.blacks;
+    }
+
+    Bitboard::ValidMoves4(self, opponent, moves);
+
+    for (auto lane = 0; lane < kLanes; ++lane) {
+      REQUIRE(moves[lane] == Bitboard::ValidMoves(self[lane], opponent[lane]));
+
+      // A random move, none for a pass.
+      if (moves[lane] != 0) {
+        moves[lane] = Bitboard::NthBit(
+          moves[lane], random.Below(Bitboard::Count(moves[lane])));
+      }
+    }
+
+    Bitboard::Flips4(self, opponent, moves, flips);
+
+    for (auto lane = 0; lane < kLanes; ++lane) {
+      REQUIRE(flips[lane] ==
+              Bitboard::Flips(self[lane], opponent[lane], moves[lane]));
+
+      const auto index = Bitboard::IndexOfLowest(moves[lane] | (1ull << 63));
+
+      if (moves[lane] == 0) {
+        states[lane].MoveAt(-1, -1);
+      } else {
+        states[lane].MoveAt(index % 8, index / 8);
+      }
+    }
+  }
+}
+
+TEST_CASE("ReversiState Playouts", "[ReversiState]") {
+  Random random(2019);
+
+  SECTION("Ends and Short Games") {
+    // Boards of different lengths, so the lanes end apart and are refilled.
+    vector<ReversiBoard> boards;
+    vector<int32_t> expected;
+
+    const ReversiState white_win(
+      "xooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "ooooooo ",
+      ReversiState::Player::kBlack);
+
+    const ReversiState draw(
+      "xxxxxxxx"
+      "xxxxxxxx"
+      "xxxxxxxx"
+      "xxxoo xx"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo",
+      ReversiState::Player::kBlack);
+
+    // White has to pass, black takes the last square and row 0.
+    const ReversiState pass(
+      " oxxxxxx"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo"
+      "oooooooo",
+      ReversiState::Player::kWhite);
+
+    const ReversiState* states[] = {&white_win, &draw, &pass};
+    const ReversiState::Player results[] = {
+      ReversiState::Player::kWhite,
+      ReversiState::Player::kDraw,
+      ReversiState::Player::kWhite};
+
+    for (auto i = 0; i < 11; ++i) {
+      boards.push_back(states[i % 3]->ToBoard());
+      expected.push_back(results[i % 3]);
+    }
+
+    for (auto count = 0; count <= 11; ++count) {
+      vector<int32_t> winners(count, -1);
+
+      ReversiGame::Simulate(boards.data(), count, &random, winners.data());
+
+      for (auto i = 0; i < count; ++i) {
+        REQUIRE(winners[i] == expected[i]);
+      }
+    }
+  }
+
+  SECTION("Same Odds as Playout") {
+    // Black wins about half of the random games from the opening.
+    const auto kCount = 40000;
+
+    const vector<ReversiBoard> boards(kCount, ReversiState().ToBoard());
+
+    vector<int32_t> winners(kCount, -1);
+
+    ReversiGame::Simulate(boards.data(), kCount, &random, winners.data());
+
+    int32_t counts_batch[3] = {0}, counts_scalar[3] = {0};
+
+    for (auto i = 0; i < kCount; ++i) {
+      counts_batch[winners[i]] += 1;
+      counts_scalar[ReversiGame::Simulate(boards[i], &random)] += 1;
+    }
+
+    // The counts differ by ~140 (one standard deviation) by chance.
+    for (auto i = 0; i < 3; ++i) {
+      REQUIRE(abs(counts_batch[i] - counts_scalar[i]) < 800);
+    }
+  }
+}
@@ -0,0 +1,198 @@
+// Copyright 2016 iRonhead
+#include <atomic>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <vector>
+
+#include "./catch/include/catch.hpp"
+#include "../reversi/board.hpp"
+#include "../reversi/reversi.hpp"
+#include "../reversi/service.hpp"
+
+using std::future;
+using std::lock_guard;
+using std::mutex;
+using std::vector;
+
+TEST_CASE("SearchService", "[SearchService]") {
+  UctOptions options;
+
+  options.seed = 25;
+
+  const ReversiState opening;
+
+  SearchRequest request;
+
+  request.board = opening.ToBoard();
+  request.count_round = 1000;
+
+  SECTION("Futures") {
+    SearchService service(options, 2);
+
+    vector<future<SearchResult>> results;
+
+    for (auto i = 0; i < 4; ++i) {
+      results.push_back(service.Submit(request));
+    }
+
+    for (auto& result : results) {
+      const auto that = result.get();
+
+      // Rounded up to whole slices.
+      REQUIRE(that.count_round == 1024);
+      REQUIRE(that.count_slices == 4);
+      REQUIRE(!that.is_end);
+      REQUIRE(!that.is_solved);
+      REQUIRE(!that.is_late);
+      REQUIRE(that.value > 0.0f);
+      REQUIRE(that.value < 1.0f);
+      REQUIRE(that.queue_milliseconds >= 0.0);
+      REQUIRE(that.search_milliseconds > 0.0);
+
+      const auto moves = opening.EnumValidMoves(opening.CurrentPlayer());
+
+      auto is_move = false;
+
+      for (const auto& move : moves) {
+        ReversiState child(opening);
+
+        child.MoveAt(move.x, move.y);
+
+        is_move = is_move || (child == ReversiState(that.best));
+      }
+
+      REQUIRE(is_move);
+    }
+  }
+
+  SECTION("Fresh Tree per Request") {
+    SearchService service(options, 1);
+
+    // The second request gets the Uct of the first, with a tree of the same
+    // position.
+    const auto first = service.Submit(request).get();
+    const auto second = service.Submit(request).get();
+
+    REQUIRE(first.count_round == second.count_round);
+    REQUIRE(first.count_root_visits == 1024);
+    REQUIRE(second.count_root_visits == first.count_root_visits);
+  }
+
+  SECTION("Callbacks") {
+    std::atomic<int32_t> count_results(0);
+
+    {
+      SearchService service(options, 2);
+
+      for (auto i = 0; i < 8; ++i) {
+        service.Submit(request, [&count_results](const SearchResult& that) {
+          count_results += (that.count_round == 1024) ? 1 : 0;
+        });
+      }
+    }
+
+    // All requests are answered before the service goes.
+    REQUIRE(count_results.load() == 8);
+  }
+
+  SECTION("Earliest Deadline First") {
+    mutex guard;
+    vector<int32_t> order;
+
+    auto fn_record = [&guard, &order](int32_t index) {
+      return [&guard, &order, index](const SearchResult&) {
+        lock_guard<mutex> lock(guard);
+
+        order.push_back(index);
+      };
+    };
+
+    {
+      SearchService service(options, 1);
+
+      // Long without a deadline, then shorter ones with later and earlier
+      // deadlines. The thread may be in a slice of any of them when the
+      // next comes, the next takes over after it.
+      request.count_round = 20 * SearchService::kSliceRounds;
+      request.deadline = 0;
+      service.Submit(request, fn_record(0));
+
+      request.count_round = 2 * SearchService::kSliceRounds;
+      request.deadline = 60000;
+      service.Submit(request, fn_record(1));
+
+      request.count_round = SearchService::kSliceRounds;
+      request.deadline = 30000;
+      service.Submit(request, fn_record(2));
+    }
+
+    REQUIRE(order == (vector<int32_t>{2, 1, 0}));
+  }
+
+  SECTION("Deadline") {
+    SearchService service(options, 1);
+
+    request.count_round = 1 << 30;
+    request.deadline = 50;
+
+    const auto result = service.Submit(request).get();
+
+    REQUIRE(result.is_late);
+    REQUIRE(result.count_round > 0);
+    REQUIRE(result.count_round < request.count_round);
+    REQUIRE(result.search_milliseconds < 1000.0);
+  }
+
+  SECTION("End") {
+    SearchService service(options, 1);
+
+    const ReversiState end(
+      "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxoooooooooooooooooooooooooooooooo",
+      ReversiState::Player::kBlack);
+
+    request.board = end.ToBoard();
+
+    const auto result = service.Submit(request).get();
+
+    REQUIRE(result.is_end);
+    REQUIRE(result.count_round == 0);
+    REQUIRE(ReversiState(result.best) == end);
+  }
+
+  SECTION("Solved") {
+    ReversiState state;
+
+    srand(10);
+
+    // A random game down to 10 empties.
+    while (64 - state.BlacksCount() - state.WhitesCount() > 10) {
+      auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+      if (moves.empty()) {
+        state.MoveAt(-1, -1);
+      } else {
+        auto move = moves[rand() % moves.size()];
+
+        state.MoveAt(move.x, move.y);
+      }
+    }
+
+    options.solve_depth = 10;
+
+    Uct<ReversiGame> uct(options);
+
+    const auto best = uct.Search(state.ToBoard());
+
+    SearchService service(options, 1);
+
+    request.board = state.ToBoard();
+
+    const auto result = service.Submit(request).get();
+
+    REQUIRE(result.is_solved);
+    REQUIRE(result.score == uct.GetReport().score);
+    REQUIRE(result.count_slices == 1);
+    REQUIRE(ReversiGame::IsSame(result.best, best));
+  }
+}
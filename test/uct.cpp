@@ -0,0 +1,858 @@
+// Copyright 2016 iRonhead
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./catch/include/catch.hpp"
+#include "../reversi/board.hpp"
+#include "../reversi/reversi.hpp"
+#include "../uct/uct.hpp"
+
+using std::chrono::milliseconds;
+using std::ifstream;
+using std::rand;
+using std::remove;
+using std::shared_ptr;
+using std::srand;
+using std::string;
+using std::this_thread::sleep_for;
+using std::vector;
+
+TEST_CASE("Uct", "[Uct]") {
+  SECTION("Same Moves as UpperConfidenceTree") {
+    UctOptions options;
+
+    options.count_round = 500;
+    options.seed = 18;
+
+    UpperConfidenceTree uct_state(options);
+    Uct<ReversiGame> uct_board(options);
+
+    ReversiState state;
+
+    for (auto ply = 0; ply < 8; ++ply) {
+      shared_ptr<State> move_state(uct_state.Search(&state));
+
+      auto move_board = uct_board.Search(state.ToBoard());
+
+      REQUIRE(*dynamic_cast<ReversiState*>(move_state.get()) ==
+              ReversiState(move_board));
+
+      state = ReversiState(move_board);
+    }
+  }
+
+  SECTION("Tree") {
+    Uct<ReversiGame> uct(100);
+
+    uct.Search(ReversiState().ToBoard());
+
+    const auto& tree = uct.GetTree();
+    const auto& root = tree.NodeAt(0);
+
+    REQUIRE(root.count_visits == 100);
+    REQUIRE(root.count_children == 4);
+
+    uint32_t count_visits = 0;
+
+    for (uint32_t i = 0; i < root.count_children; ++i) {
+      const auto& child = tree.NodeAt(root.first_child + i);
+
+      REQUIRE(child.parent == 0);
+
+      count_visits += child.count_visits;
+    }
+
+    REQUIRE(count_visits == root.count_visits);
+  }
+
+  SECTION("Root Parallel") {
+    UctOptions options;
+
+    options.count_round = 1001;
+    options.count_threads = 4;
+
+    Uct<ReversiGame> uct(options);
+
+    ReversiState state;
+
+    auto move = ReversiState(uct.Search(state.ToBoard()));
+    auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+    auto is_valid_move = false;
+
+    for (auto m : moves) {
+      ReversiState temp(state);
+
+      temp.MoveAt(m.x, m.y);
+
+      is_valid_move = is_valid_move || temp == move;
+    }
+
+    REQUIRE(is_valid_move);
+
+    // The first thread takes the extra round.
+    REQUIRE(uct.GetTree().NodeAt(0).count_visits == 251);
+  }
+
+  SECTION("Tree Parallel") {
+    UctOptions options;
+
+    options.count_round = 2000;
+    options.count_threads = 4;
+    options.parallelism = UctOptions::kTree;
+    options.virtual_loss = 3;
+
+    Uct<ReversiGame> uct(options);
+
+    ReversiState state;
+
+    auto move = ReversiState(uct.Search(state.ToBoard()));
+    auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+    auto is_valid_move = false;
+
+    for (auto m : moves) {
+      ReversiState temp(state);
+
+      temp.MoveAt(m.x, m.y);
+
+      is_valid_move = is_valid_move || temp == move;
+    }
+
+    REQUIRE(is_valid_move);
+
+    // All rounds land in the one tree and the virtual losses are all taken
+    // back, a node is visited at least as many times as its children.
+    const auto& tree = uct.GetTree();
+
+    REQUIRE(tree.NodeAt(0).count_visits == 2000);
+
+    vector<uint32_t> indices(1, 0);
+
+    while (!indices.empty()) {
+      const auto& node = tree.NodeAt(indices.back());
+
+      indices.pop_back();
+
+      uint32_t count_visits = 0;
+
+      for (uint32_t i = 0; i < node.count_children; ++i) {
+        count_visits += tree.NodeAt(node.first_child + i).count_visits;
+
+        indices.push_back(node.first_child + i);
+      }
+
+      REQUIRE(node.count_visits >= count_visits);
+    }
+  }
+
+  SECTION("Limits") {
+    ReversiState state;
+
+    {
+      Uct<ReversiGame> uct(300);
+
+      uct.Search(state.ToBoard());
+
+      REQUIRE(uct.GetReport().count_round == 300);
+      REQUIRE(uct.GetReport().count_nodes == uct.GetTree().CountNodes());
+      REQUIRE(uct.GetReport().count_bytes >= uct.GetTree().CountBytes());
+    }
+
+    {
+      UctOptions options;
+
+      options.count_round = 0;
+      options.time_limit = 50;
+
+      Uct<ReversiGame> uct(options);
+
+      uct.Search(state.ToBoard());
+
+      REQUIRE(uct.GetReport().count_round > 0);
+      REQUIRE(uct.GetReport().milliseconds >= 50.0);
+      REQUIRE(uct.GetReport().milliseconds < 1000.0);
+    }
+
+    for (auto parallelism : {UctOptions::kRoot, UctOptions::kTree}) {
+      UctOptions options;
+
+      options.count_round = 0;
+      options.count_node_limit = 2000;
+      options.count_threads = 2;
+      options.parallelism = parallelism;
+
+      Uct<ReversiGame> uct(options);
+
+      uct.Search(state.ToBoard());
+
+      // One expansion per thread may go over.
+      REQUIRE(uct.GetReport().count_nodes >= 2000);
+      REQUIRE(uct.GetReport().count_nodes <=
+              2000 + 2 * ReversiGame::kMaxChildren);
+    }
+  }
+
+  SECTION("Reuse Tree") {
+    UctOptions options;
+
+    options.count_round = 1000;
+    options.reuse_tree = true;
+
+    Uct<ReversiGame> uct(options);
+
+    // Visits of the best move and of its first reply in the last search,
+    // the tree is rebuilt by each search.
+    auto fn_visits = [&](const ReversiBoard& board) {
+      const auto& tree = uct.GetTree();
+      const auto& root = tree.NodeAt(0);
+
+      for (uint32_t i = 0; i < root.count_children; ++i) {
+        if (ReversiGame::IsSame(tree.BoardAt(root.first_child + i), board)) {
+          return tree.NodeAt(root.first_child + i).count_visits.load();
+        }
+      }
+
+      return 0u;
+    };
+
+    ReversiState state;
+
+    auto move = uct.Search(state.ToBoard());
+
+    REQUIRE(uct.GetReport().count_reused_visits == 0);
+
+    auto count_visits = fn_visits(move);
+
+    // The best move of the last search is the root of the next one.
+    move = uct.Search(move);
+
+    REQUIRE(count_visits > 0);
+    REQUIRE(uct.GetReport().count_reused_visits == count_visits);
+    REQUIRE(uct.GetTree().NodeAt(0).count_visits == count_visits + 1000);
+
+    // So is a grandchild, the reply of the opponent.
+    const auto& tree = uct.GetTree();
+    const auto& child = tree.NodeAt(tree.NodeAt(0).first_child);
+    const auto reply = tree.BoardAt(child.first_child);
+
+    count_visits = tree.NodeAt(child.first_child).count_visits;
+
+    uct.Search(reply);
+
+    REQUIRE(count_visits > 0);
+    REQUIRE(uct.GetReport().count_reused_visits == count_visits);
+    REQUIRE(ReversiGame::IsSame(uct.GetTree().BoardAt(0), reply));
+    REQUIRE(uct.GetTree().NodeAt(0).parent == Tree<ReversiBoard>::kNull);
+
+    // A root which is not in the tree starts over.
+    uct.Search(state.ToBoard());
+
+    REQUIRE(uct.GetReport().count_reused_visits == 0);
+    REQUIRE(uct.GetTree().NodeAt(0).count_visits == 1000);
+  }
+
+  SECTION("Reuse Tree of States") {
+    for (auto parallelism : {UctOptions::kRoot, UctOptions::kTree}) {
+      UctOptions options;
+
+      options.count_round = 1000;
+      options.count_threads = 4;
+      options.parallelism = parallelism;
+      options.reuse_tree = true;
+
+      UpperConfidenceTree uct(options);
+
+      ReversiState state;
+
+      shared_ptr<State> move(uct.Search(&state));
+
+      REQUIRE(uct.GetReport().count_reused_visits == 0);
+
+      // The same root, then a child. The states of a shared tree are in the
+      // arenas of all threads.
+      delete uct.Search(&state);
+
+      REQUIRE(uct.GetReport().count_reused_visits > 0);
+
+      delete uct.Search(move.get());
+
+      REQUIRE(uct.GetReport().count_reused_visits > 0);
+    }
+  }
+
+  SECTION("Ponder") {
+    for (auto count_threads : {1, 2}) {
+      UctOptions options;
+
+      options.count_round = 500;
+      options.count_threads = count_threads;
+      options.parallelism = UctOptions::kTree;
+
+      Uct<ReversiGame> uct(options);
+
+      ReversiState state;
+
+      auto move = uct.Search(state.ToBoard());
+
+      // Nothing to stop.
+      uct.StopPonder();
+
+      REQUIRE_FALSE(uct.IsPondering());
+
+      uct.StartPonder(move);
+
+      REQUIRE(uct.IsPondering());
+
+      sleep_for(milliseconds(20));
+
+      uct.StopPonder();
+
+      REQUIRE_FALSE(uct.IsPondering());
+      REQUIRE(uct.GetPonderStats().count_round > 0);
+
+      // A reply of the opponent, searched while pondering.
+      const auto& tree = uct.GetTree();
+      const auto reply = tree.BoardAt(tree.NodeAt(0).first_child);
+      const auto count_visits =
+        tree.NodeAt(tree.NodeAt(0).first_child).count_visits.load();
+
+      uct.Search(reply);
+
+      REQUIRE(uct.GetPonderStats().count_hit == 1);
+      REQUIRE(uct.GetPonderStats().count_miss == 0);
+      REQUIRE(uct.GetPonderStats().count_reused_visits == count_visits);
+      REQUIRE(uct.GetReport().count_reused_visits == count_visits);
+
+      // A search stops pondering by itself, on a miss the tree starts over.
+      uct.StartPonder(reply);
+
+      uct.Search(state.ToBoard());
+
+      REQUIRE_FALSE(uct.IsPondering());
+      REQUIRE(uct.GetPonderStats().count_hit == 1);
+      REQUIRE(uct.GetPonderStats().count_miss == 1);
+      REQUIRE(uct.GetTree().NodeAt(0).count_visits == 500);
+
+      // Pondering is stopped when the search goes away.
+      uct.StartPonder(state.ToBoard());
+    }
+  }
+}
+
+TEST_CASE("Uct Symmetries", "[Uct]") {
+  UctOptions options;
+
+  options.count_round = 1000;
+  options.merge_symmetries = true;
+
+  Uct<ReversiGame> uct(options);
+
+  ReversiState state;
+
+  auto move = ReversiState(uct.Search(state.ToBoard()));
+
+  // The 4 first moves are one.
+  REQUIRE(uct.GetTree().NodeAt(0).count_children == 1);
+  REQUIRE(uct.GetReport().count_merged >= 3);
+  REQUIRE(state.IsValidMoveAt(4, 2, state.CurrentPlayer()));
+
+  // The first of them is kept.
+  state.MoveAt(4, 2);
+
+  REQUIRE(move == state);
+}
+
+TEST_CASE("TranspositionTable", "[Uct]") {
+  // 2 buckets.
+  TranspositionTable table(128);
+
+  REQUIRE(table.CountEntries() == 8);
+
+  SECTION("Find & Insert") {
+    REQUIRE(table.Find(1) == nullptr);
+
+    auto entry = table.Insert(1);
+
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->count_visits == 0);
+
+    entry->count_visits = 3;
+
+    REQUIRE(table.Find(1) == entry);
+    REQUIRE(table.Insert(1) == entry);
+    REQUIRE(table.Find(1)->count_visits == 3);
+
+    table.Clear();
+
+    REQUIRE(table.Find(1) == nullptr);
+  }
+
+  SECTION("Age") {
+    table.Insert(2)->count_visits = 100;
+    table.Insert(4)->count_visits = 100;
+
+    table.Age();
+
+    REQUIRE(table.Find(2) == nullptr);
+
+    // Entries of older searches go first, whatever their visits.
+    for (uint64_t key = 6; key <= 10; key += 2) {
+      table.Insert(key)->count_visits = 1;
+    }
+
+    REQUIRE(table.Insert(12)->count_visits == 0);
+    REQUIRE(table.Find(6) != nullptr);
+    REQUIRE(table.Find(8) != nullptr);
+    REQUIRE(table.Find(10) != nullptr);
+  }
+
+  SECTION("Replace the Fewest Visits") {
+    // Keys 2, 4, 6, 8, 10 all go into bucket 0.
+    for (uint64_t key = 2; key <= 8; key += 2) {
+      table.Insert(key)->count_visits = static_cast<uint32_t>(key);
+    }
+
+    table.Insert(10);
+
+    REQUIRE(table.Find(2) == nullptr);
+    REQUIRE(table.Find(4) != nullptr);
+    REQUIRE(table.Find(10) != nullptr);
+
+    // The other bucket is untouched.
+    REQUIRE(table.Insert(1)->count_visits == 0);
+    REQUIRE(table.Find(4) != nullptr);
+  }
+}
+
+TEST_CASE("Uct Transpositions", "[Uct]") {
+  for (auto count_threads : {1, 2}) {
+    UctOptions options;
+
+    options.count_round = 3000;
+    options.count_threads = count_threads;
+    options.parallelism = UctOptions::kTree;
+    options.transposition_table_size = 1 << 20;
+
+    Uct<ReversiGame> uct(options);
+
+    ReversiState state;
+
+    // A few plies in, so the tree is deep enough for transpositions.
+    for (auto ply = 0; ply < 2; ++ply) {
+      auto m = state.EnumValidMoves(state.CurrentPlayer()).front();
+
+      state.MoveAt(m.x, m.y);
+    }
+
+    auto move = ReversiState(uct.Search(state.ToBoard()));
+    auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+    auto is_valid_move = false;
+
+    for (auto m : moves) {
+      ReversiState temp(state);
+
+      temp.MoveAt(m.x, m.y);
+
+      is_valid_move = is_valid_move || temp == move;
+    }
+
+    REQUIRE(is_valid_move);
+    REQUIRE(uct.GetReport().count_probes > 0);
+    REQUIRE(uct.GetReport().count_transpositions > 0);
+    REQUIRE(uct.GetTree().NodeAt(0).count_visits == 3000);
+  }
+}
+
+TEST_CASE("Uct Solver", "[Uct]") {
+  ReversiState state;
+
+  srand(10);
+
+  // A random game down to 10 empties.
+  while (64 - state.BlacksCount() - state.WhitesCount() > 10) {
+    auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+    if (moves.empty()) {
+      state.MoveAt(-1, -1);
+    } else {
+      auto move = moves[rand() % moves.size()];
+
+      state.MoveAt(move.x, move.y);
+    }
+  }
+
+  REQUIRE(!state.IsEnd());
+
+  const auto board = state.ToBoard();
+  const auto black = board.player == ReversiState::Player::kBlack;
+
+  EndgameSolver solver;
+
+  uint64_t move;
+
+  const auto score = black
+    ? solver.Solve(board.blacks, board.whites, &move)
+    : solver.Solve(board.whites, board.blacks, &move);
+
+  UctOptions options;
+
+  options.count_round = 100;
+  options.solve_depth = 10;
+
+  SECTION("Solved Root") {
+    Uct<ReversiGame> uct(options);
+
+    auto best = uct.Search(board);
+
+    REQUIRE(uct.GetReport().is_solved);
+    REQUIRE(uct.GetReport().score == score);
+    REQUIRE(uct.GetReport().count_round == 0);
+
+    // The root and the move.
+    REQUIRE(uct.GetTree().CountNodes() == 2);
+    REQUIRE(uct.GetTree().NodeAt(0).count_children == 1);
+
+    // The move keeps the score.
+    uint64_t reply;
+
+    const auto best_score = black
+      ? solver.Solve(best.whites, best.blacks, &reply)
+      : solver.Solve(best.blacks, best.whites, &reply);
+
+    REQUIRE(best_score == -score);
+  }
+
+  SECTION("Same Move as UpperConfidenceTree") {
+    Uct<ReversiGame> uct(options);
+    UpperConfidenceTree uct_state(options);
+
+    shared_ptr<State> move_state(uct_state.Search(&state));
+
+    REQUIRE(uct_state.GetReport().is_solved);
+    REQUIRE(*dynamic_cast<ReversiState*>(move_state.get()) ==
+            ReversiState(uct.Search(board)));
+  }
+
+  SECTION("Too Many Empties") {
+    options.solve_depth = 9;
+
+    Uct<ReversiGame> uct(options);
+
+    uct.Search(board);
+
+    REQUIRE(!uct.GetReport().is_solved);
+    REQUIRE(uct.GetReport().count_round == 100);
+  }
+}
+
+TEST_CASE("Uct Proofs", "[Uct]") {
+  ReversiState state;
+
+  srand(16);
+
+  // A random game down to 10 empties, which is proven in a few thousand
+  // rounds.
+  while (64 - state.BlacksCount() - state.WhitesCount() > 10) {
+    auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+    if (moves.empty()) {
+      state.MoveAt(-1, -1);
+    } else {
+      auto move = moves[rand() % moves.size()];
+
+      state.MoveAt(move.x, move.y);
+    }
+  }
+
+  const auto board = state.ToBoard();
+  const auto black = board.player == ReversiState::Player::kBlack;
+
+  EndgameSolver solver;
+
+  uint64_t move;
+
+  const auto score = black
+    ? solver.Solve(board.blacks, board.whites, &move)
+    : solver.Solve(board.whites, board.blacks, &move);
+
+  // A decided game, see "Uct Proven Draws" for a drawn one.
+  REQUIRE(score != 0);
+
+  UctOptions options;
+
+  options.count_round = 1000000;
+  options.prove = true;
+
+  auto fn_check = [&](Uct<ReversiGame>* uct) {
+    auto best = uct->Search(board);
+
+    const auto& report = uct->GetReport();
+
+    REQUIRE(report.is_proven);
+    REQUIRE(report.count_round < options.count_round);
+
+    // The root is moved into by the other player.
+    const auto flags = uct->GetTree().NodeAt(0).flags.load();
+
+    REQUIRE(((flags & Node::kProvenLoss) != 0) == (score > 0));
+    REQUIRE(((flags & Node::kProvenWin) != 0) == (score < 0));
+
+    // A won game stays won.
+    if (score > 0) {
+      uint64_t reply;
+
+      const auto best_score = black
+        ? solver.Solve(best.whites, best.blacks, &reply)
+        : solver.Solve(best.blacks, best.whites, &reply);
+
+      REQUIRE(best_score < 0);
+    }
+  };
+
+  SECTION("One Thread") {
+    Uct<ReversiGame> uct(options);
+
+    fn_check(&uct);
+  }
+
+  SECTION("Tree Parallel") {
+    options.count_threads = 4;
+    options.parallelism = UctOptions::kTree;
+
+    Uct<ReversiGame> uct(options);
+
+    fn_check(&uct);
+  }
+
+  SECTION("Reuse Tree") {
+    options.reuse_tree = true;
+
+    Uct<ReversiGame> uct(options);
+
+    fn_check(&uct);
+
+    // The proven tree is carried over, the search stops at once.
+    uct.Search(board);
+
+    REQUIRE(uct.GetReport().is_proven);
+    REQUIRE(uct.GetReport().count_round == 1);
+  }
+}
+
+TEST_CASE("Uct Proven Draws", "[Uct]") {
+  // White has one move left, which ends the game 32 to 32.
+  const ReversiState state(
+    "ooxxxxxxooo.oooxxxoxxxxxoxoooxoxooxoooxxoooxxxxxooooxoxxoooxxxxx",
+    ReversiState::Player::kWhite);
+
+  ReversiState end(state);
+
+  end.MoveAt(3, 1);
+
+  REQUIRE(end.IsEnd());
+  REQUIRE(end.Winner() == ReversiState::Player::kDraw);
+
+  // The playouts reward a draw as a win of both players, the proofs do not.
+  REQUIRE(ReversiGame::Reward(end.ToBoard(), end.Winner()) == 1.0f);
+  REQUIRE(ReversiGame::Outcome(end.ToBoard()) == 0);
+  REQUIRE(end.Outcome() == 0);
+
+  UctOptions options;
+
+  options.count_round = 1000;
+  options.prove = true;
+
+  Uct<ReversiGame> uct(options);
+
+  uct.Search(state.ToBoard());
+
+  const auto& tree = uct.GetTree();
+  const auto& root = tree.NodeAt(0);
+
+  // REQUIRE would take the address of Node::kProvenDraw.
+  const uint16_t draw = Node::kProvenDraw;
+
+  REQUIRE(uct.GetReport().is_proven);
+  REQUIRE(uct.GetReport().count_round == 1);
+  REQUIRE(root.count_children == 1);
+  REQUIRE((root.flags.load() & Node::kProven) == draw);
+  REQUIRE((tree.NodeAt(root.first_child).flags.load() & Node::kProven) ==
+          draw);
+}
+
+TEST_CASE("Uct Proven Wins after the First Child", "[Uct]") {
+  // Black has 7 moves, the third takes the last white stones.
+  const ReversiState state(
+    "....x......xx.x...oxxxxx..oooox...oxx..x...xxx..................",
+    ReversiState::Player::kBlack);
+
+  UctOptions options;
+
+  options.count_round = 1000;
+  options.prove = true;
+
+  Uct<ReversiGame> uct(options);
+
+  uct.Search(state.ToBoard());
+
+  const auto& tree = uct.GetTree();
+  const auto& root = tree.NodeAt(0);
+
+  // REQUIRE would take the addresses of Node::kProvenWin and kProvenLoss.
+  const uint16_t win = Node::kProvenWin;
+  const uint16_t loss = Node::kProvenLoss;
+
+  REQUIRE(root.count_children == 7);
+  REQUIRE(!ReversiGame::IsEnd(tree.BoardAt(root.first_child)));
+  REQUIRE(ReversiGame::IsEnd(tree.BoardAt(root.first_child + 2)));
+  REQUIRE((tree.NodeAt(root.first_child + 2).flags.load() & Node::kProven) ==
+          win);
+
+  // The root is proven as it is expanded, not once all children are.
+  REQUIRE(uct.GetReport().is_proven);
+  REQUIRE(uct.GetReport().count_round == 1);
+  REQUIRE((root.flags.load() & Node::kProven) == loss);
+}
+
+TEST_CASE("Random", "[Uct]") {
+  Random random(18);
+
+  SECTION("Same Seed, Same Numbers") {
+    Random other(18);
+
+    for (auto i = 0; i < 100; ++i) {
+      REQUIRE(random.Next() == other.Next());
+    }
+
+    other.Seed(19);
+
+    REQUIRE(random.Next() != other.Next());
+  }
+
+  SECTION("Below") {
+    // 20 moves, each drawn ~10000 times.
+    vector<int32_t> counts(20, 0);
+
+    for (auto i = 0; i < 200000; ++i) {
+      const auto n = random.Below(20);
+
+      REQUIRE(n < 20);
+
+      counts[n] += 1;
+    }
+
+    for (const auto count : counts) {
+      REQUIRE(count > 9500);
+      REQUIRE(count < 10500);
+    }
+
+    REQUIRE(random.Below(1) == 0);
+  }
+}
+
+TEST_CASE("Uct Seeds", "[Uct]") {
+  UctOptions options;
+
+  options.count_round = 2000;
+  options.seed = 18;
+
+  const auto board = ReversiState().ToBoard();
+
+  // Visits of the root children, one search apart.
+  auto fn_visits = [&board](Uct<ReversiGame>* uct) {
+    vector<uint32_t> visits;
+
+    uct->Search(board);
+
+    const auto& tree = uct->GetTree();
+    const auto& root = tree.NodeAt(0);
+
+    for (uint32_t i = 0; i < root.count_children; ++i) {
+      visits.push_back(tree.NodeAt(root.first_child + i).count_visits.load());
+    }
+
+    return visits;
+  };
+
+  Uct<ReversiGame> uct(options);
+
+  const auto visits = fn_visits(&uct);
+
+  SECTION("Same Seed, Same Search") {
+    Uct<ReversiGame> other(options);
+
+    REQUIRE(fn_visits(&other) == visits);
+
+    uct.Seed(18);
+
+    REQUIRE(fn_visits(&uct) == visits);
+  }
+
+  SECTION("Other Seed, Other Search") {
+    options.seed = 19;
+
+    Uct<ReversiGame> other(options);
+
+    REQUIRE(fn_visits(&other) != visits);
+  }
+}
+
+TEST_CASE("Uct Stats", "[Uct]") {
+  const char* path = "test_uct_stats.json";
+
+  UctOptions options;
+
+  options.count_round = 1000;
+  options.stats_path = path;
+
+  remove(path);
+
+  Uct<ReversiGame> uct(options);
+
+  uct.Search(ReversiState().ToBoard());
+
+  const auto& report = uct.GetReport();
+  const auto& stats = report.stats;
+
+#ifdef UCT_STATS
+  REQUIRE(stats.count_iterations == 1000);
+  REQUIRE(stats.count_nodes_allocated + 1 == report.count_nodes);
+  REQUIRE(stats.AverageSelectDepth() >= 1.0);
+  REQUIRE(stats.max_select_depth >= stats.AverageSelectDepth());
+
+  // At most 60 moves per playout.
+  REQUIRE(stats.count_playout_plies > 1000);
+  REQUIRE(stats.count_playout_plies <= 60 * 1000);
+  REQUIRE(stats.nanoseconds_simulate > 0);
+#else
+  REQUIRE(stats.count_iterations == 0);
+  REQUIRE(stats.count_playout_plies == 0);
+  REQUIRE(stats.nanoseconds_simulate == 0);
+#endif  // UCT_STATS
+
+  // One line per search.
+  uct.Search(ReversiState().ToBoard());
+
+  ifstream file(path);
+  string line;
+  vector<string> lines;
+
+  while (getline(file, line)) {
+    lines.push_back(line);
+  }
+
+  REQUIRE(lines.size() == 2);
+  REQUIRE(lines[1].find("{\"count_round\": 1000, ") == 0);
+  REQUIRE(lines[1].find("\"stats\": {\"count_iterations\": ") !=
+          string::npos);
+
+  remove(path);
+}
@@ -0,0 +1,330 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../reversi/bitboard.hpp"
+#include "../reversi/board.hpp"
+#include "../reversi/reversi.hpp"
+#include "../uct/uct.hpp"
+
+using std::atoi;
+using std::cerr;
+using std::cin;
+using std::condition_variable;
+using std::cout;
+using std::deque;
+using std::endl;
+using std::fixed;
+using std::getline;
+using std::ifstream;
+using std::istream;
+using std::map;
+using std::max;
+using std::mutex;
+using std::ostringstream;
+using std::pair;
+using std::setprecision;
+using std::sort;
+using std::strcmp;
+using std::string;
+using std::thread;
+using std::unique_lock;
+using std::vector;
+
+namespace {
+// Throughput is printed once per this many positions.
+const int64_t kReportInterval = 1000;
+
+// Positions read ahead of the output per thread, see Analysis::window.
+const int64_t kWindowPerThread = 16;
+
+// Positions read and not written yet, shared by the reader and the threads.
+// The reader waits while window positions are out, so memory stays bounded
+// however long the input is. Results are written in the order of the input,
+// those which are done early wait in results.
+struct Analysis {
+  UctOptions                    options;
+  int64_t                       window;
+
+  mutex                         guard;
+  condition_variable            condition;
+  deque<pair<int64_t, string>>  pending;
+  map<int64_t, string>          results;
+  int64_t                       count_read;
+  int64_t                       count_written;
+  bool                          is_eof;
+
+  // Rounds of all searches, for the throughput.
+  int64_t                       count_round;
+  std::chrono::steady_clock::time_point start;
+};
+
+//------------------------------------------------------------------------------
+// The square played from board into child as reversi_game reads it (column
+// digit, row letter), "pass" if none is.
+string MoveOf(const ReversiBoard& board, const ReversiBoard& child) {
+  const auto stones = board.blacks | board.whites;
+  const auto move = (child.blacks | child.whites) & ~stones;
+
+  if (move == 0) { return "pass"; }
+
+  const auto index = Bitboard::IndexOfLowest(move);
+
+  ostringstream text;
+
+  text << index % 8 << static_cast<char>('A' + index / 8);
+
+  return text.str();
+}
+
+//------------------------------------------------------------------------------
+// Search the position of line, 64 stones as ReversiState takes them then x or
+// o to move, and return the line of output:
+//
+//   best value move:visits ...   the most visited move, its mean reward for
+//                                the player to move and the visits of the
+//                                root children, the most visited first
+//   best value solved score      solved exactly, the final disc difference
+//   end                          the game is over
+//   error                        line is not a position
+string Analyze(Uct<ReversiGame>* uct, const string& line,
+               int32_t* count_round) {
+  *count_round = 0;
+
+  const auto player = line.find_first_not_of(" \t", 64);
+
+  if (line.size() < 64 || player == string::npos ||
+      (line[player] != 'x' && line[player] != 'o')) {
+    return "error";
+  }
+
+  const ReversiState state(line.c_str(), line[player] == 'x'
+    ? ReversiState::Player::kBlack : ReversiState::Player::kWhite);
+
+  const auto board = state.ToBoard();
+
+  if (ReversiGame::IsEnd(board)) { return "end"; }
+
+  uct->Search(board);
+
+  const auto& report = uct->GetReport();
+  const auto& tree = uct->GetTree();
+  const auto& root = tree.NodeAt(0);
+
+  *count_round = report.count_round;
+
+  // Children by visits, the most visited first.
+  vector<pair<uint32_t, uint32_t>> children;
+
+  for (uint32_t i = 0; i < root.count_children; ++i) {
+    children.emplace_back(
+      tree.NodeAt(root.first_child + i).count_visits.load(),
+      root.first_child + i);
+  }
+
+  sort(children.rbegin(), children.rend());
+
+  ostringstream text;
+
+  text << MoveOf(board, tree.BoardAt(children[0].second)) << " "
+       << fixed << setprecision(3);
+
+  if (report.is_solved) {
+    text << (report.score > 0 ? 1.0 : report.score < 0 ? 0.0 : 0.5)
+         << " solved " << report.score;
+
+    return text.str();
+  }
+
+  const auto visits = max(children[0].first, 1u);
+
+  text << tree.NodeAt(children[0].second).count_wins.load() / visits;
+
+  for (const auto& child : children) {
+    text << " " << MoveOf(board, tree.BoardAt(child.second)) << ":"
+         << child.first;
+  }
+
+  return text.str();
+}
+
+//------------------------------------------------------------------------------
+void Report(const Analysis& analysis) {
+  const std::chrono::duration<double> seconds =
+    std::chrono::steady_clock::now() - analysis.start;
+
+  cerr << fixed << setprecision(1) << analysis.count_written
+       << " positions in " << seconds.count() << " s, "
+       << analysis.count_written / seconds.count() << " positions/s, "
+       << setprecision(0) << analysis.count_round / seconds.count()
+       << " rounds/s" << endl;
+}
+
+//------------------------------------------------------------------------------
+void Work(Analysis* analysis) {
+  Uct<ReversiGame> uct(analysis->options);
+
+  unique_lock<mutex> lock(analysis->guard);
+
+  while (true) {
+    analysis->condition.wait(lock, [analysis]() {
+      return !analysis->pending.empty() || analysis->is_eof;
+    });
+
+    if (analysis->pending.empty()) { break; }
+
+    const auto index = analysis->pending.front().first;
+    const auto line = analysis->pending.front().second;
+
+    analysis->pending.pop_front();
+
+    lock.unlock();
+
+    int32_t count_round;
+
+    auto result = Analyze(&uct, line, &count_round);
+
+    lock.lock();
+
+    analysis->count_round += count_round;
+    analysis->results[index].swap(result);
+
+    // Write what is done in the order of the input.
+    for (auto it = analysis->results.begin();
+         it != analysis->results.end() &&
+         it->first == analysis->count_written;
+         it = analysis->results.erase(it)) {
+      cout << it->second << '\n';
+
+      analysis->count_written += 1;
+
+      if (analysis->count_written % kReportInterval == 0) {
+        Report(*analysis);
+      }
+    }
+
+    analysis->condition.notify_all();
+  }
+}
+}  // namespace
+
+// ./a.out [path] [--rounds n] [--time ms] [--threads n] [--solve n]
+//
+// Search each position of path (stdin if there is none or it is -), one per
+// line as 64 stones (x black, o white, anything else empty) then x or o to
+// move, with rounds (10000) or ms per position, on threads (all cores)
+// positions at a time. Write one line per position to stdout in the order of
+// the input, see Analyze, and the throughput to stderr. Positions with at
+// most solve (0) empty squares are solved exactly.
+int main(int argc, char** argv) {
+  Analysis analysis;
+
+  int32_t count_threads = max(1u, thread::hardware_concurrency());
+  const char* path = nullptr;
+
+  auto is_usage = false;
+
+  for (auto i = 1; i < argc && !is_usage; ++i) {
+    const auto has_value = i + 1 < argc;
+
+    if (strcmp(argv[i], "--rounds") == 0 && has_value) {
+      analysis.options.count_round = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--time") == 0 && has_value) {
+      analysis.options.time_limit = atoi(argv[++i]);
+      analysis.options.count_round = 0;
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      count_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--solve") == 0 && has_value) {
+      analysis.options.solve_depth = atoi(argv[++i]);
+    } else if ((path == nullptr && argv[i][0] != '-') ||
+               strcmp(argv[i], "-") == 0) {
+      path = argv[i];
+    } else {
+      is_usage = true;
+    }
+  }
+
+  if (is_usage || count_threads <= 0 ||
+      (analysis.options.count_round <= 0 &&
+       analysis.options.time_limit <= 0)) {
+    cout << "usage: " << argv[0] << " [path] [--rounds n] [--time ms] "
+         << "[--threads n] [--solve n]" << endl;
+
+    return 1;
+  }
+
+  ifstream file;
+
+  if (path != nullptr && strcmp(path, "-") != 0) {
+    file.open(path);
+
+    if (!file) {
+      cerr << "can not read " << path << endl;
+
+      return 1;
+    }
+  }
+
+  istream& input = file.is_open() ? file : cin;
+
+  analysis.window = count_threads * kWindowPerThread;
+  analysis.count_read = 0;
+  analysis.count_written = 0;
+  analysis.is_eof = false;
+  analysis.count_round = 0;
+  analysis.start = std::chrono::steady_clock::now();
+
+  vector<thread> threads;
+
+  for (auto i = 0; i < count_threads; ++i) {
+    threads.emplace_back(Work, &analysis);
+  }
+
+  string line;
+
+  while (getline(input, line)) {
+    unique_lock<mutex> lock(analysis.guard);
+
+    analysis.condition.wait(lock, [&analysis]() {
+      return analysis.count_read - analysis.count_written < analysis.window;
+    });
+
+    analysis.pending.emplace_back(analysis.count_read++, line);
+    analysis.condition.notify_all();
+  }
+
+  {
+    unique_lock<mutex> lock(analysis.guard);
+
+    analysis.is_eof = true;
+    analysis.condition.notify_all();
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  cout.flush();
+
+  // The last report may have been printed already.
+  if (analysis.count_written % kReportInterval != 0 ||
+      analysis.count_written == 0) {
+    Report(analysis);
+  }
+
+  return 0;
+}
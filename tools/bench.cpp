@@ -0,0 +1,422 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../reversi/board.hpp"
+#include "../reversi/perft.hpp"
+#include "../reversi/reversi.hpp"
+#include "../uct/uct.hpp"
+
+using std::atof;
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::ifstream;
+using std::max;
+using std::ofstream;
+using std::ostream;
+using std::ostringstream;
+using std::pair;
+using std::setprecision;
+using std::shared_ptr;
+using std::strcmp;
+using std::string;
+using std::strtod;
+using std::vector;
+
+namespace {
+typedef std::chrono::steady_clock Clock;
+
+// Everything is seeded, two runs search the same trees.
+const uint64_t kSeed = 2016;
+
+// Positions after this many random moves from the opening.
+const int32_t kPositionPlies[] = {8, 16, 24, 32, 40, 48};
+
+// The opening is searched to kPerftDepth, the other positions to
+// kPerftDepthPositions.
+const int32_t kPerftDepth = 8;
+const int32_t kPerftDepthPositions = 5;
+const uint64_t kPerftOpening = 390216;
+
+// Perft over the bitboards, on one thread without a table.
+const int32_t kBitboardPerftDepth = 10;
+const uint64_t kBitboardPerftOpening = 24571284;
+
+// Playouts of each position.
+const int32_t kCountPlayouts = 50000;
+
+// Rounds of the search of each position.
+const int32_t kCountRounds = 20000;
+
+// Each measurement is taken this many times, the fastest is kept.
+const int32_t kCountRepeats = 3;
+
+// A metric and if more of it is better.
+struct Metric {
+  string  name;
+  double  value;
+  bool    is_higher_better;
+};
+
+//------------------------------------------------------------------------------
+double SecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+// Leaves depth plies below state, a pass is a move and an end is a leaf.
+uint64_t Paths(ReversiState state, int32_t depth) {
+  if (depth == 0) { return 1; }
+
+  auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+  if (moves.empty()) {
+    if (state.IsEnd()) { return 1; }
+
+    state.MoveAt(-1, -1);
+
+    return Paths(state, depth - 1);
+  }
+
+  uint64_t count = 0;
+
+  for (const auto& move : moves) {
+    ReversiState child(state);
+
+    child.MoveAt(move.x, move.y);
+
+    count += Paths(child, depth - 1);
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+vector<ReversiState> Positions() {
+  vector<ReversiState> positions;
+
+  Random random(kSeed);
+
+  for (const auto plies : kPositionPlies) {
+    ReversiState state;
+
+    for (auto ply = 0; ply < plies && !state.IsEnd(); ++ply) {
+      auto moves = state.EnumValidMoves(state.CurrentPlayer());
+
+      if (moves.empty()) {
+        state.MoveAt(-1, -1);
+      } else {
+        const auto& move = moves[random.Below(moves.size())];
+
+        state.MoveAt(move.x, move.y);
+      }
+    }
+
+    positions.push_back(state);
+  }
+
+  return positions;
+}
+
+//------------------------------------------------------------------------------
+void BenchPerft(const vector<ReversiState>& positions,
+                vector<Metric>* metrics) {
+  uint64_t count_nodes = 0;
+  double seconds = 0.0;
+
+  for (auto i = 0; i < kCountRepeats; ++i) {
+    const auto start = Clock::now();
+
+    const auto count_opening = Paths(ReversiState(), kPerftDepth);
+
+    count_nodes = count_opening;
+
+    for (const auto& position : positions) {
+      count_nodes += Paths(position, kPerftDepthPositions);
+    }
+
+    const auto elapsed = SecondsSince(start);
+
+    seconds = (i == 0) ? elapsed : std::min(seconds, elapsed);
+
+    if (count_opening != kPerftOpening) {
+      cerr << "perft " << kPerftDepth << " of the opening is "
+           << count_opening << ", not " << kPerftOpening << endl;
+    }
+  }
+
+  metrics->push_back({"perft_nodes", static_cast<double>(count_nodes), true});
+  metrics->push_back({"perft_nodes_per_second", count_nodes / seconds, true});
+
+  Perft perft;
+
+  for (auto i = 0; i < kCountRepeats; ++i) {
+    const auto start = Clock::now();
+
+    count_nodes = perft.Count(ReversiState(), kBitboardPerftDepth);
+
+    const auto elapsed = SecondsSince(start);
+
+    seconds = (i == 0) ? elapsed : std::min(seconds, elapsed);
+
+    if (count_nodes != kBitboardPerftOpening) {
+      cerr << "bitboard perft " << kBitboardPerftDepth << " of the opening is "
+           << count_nodes << ", not " << kBitboardPerftOpening << endl;
+    }
+  }
+
+  metrics->push_back(
+    {"bitboard_perft_paths_per_second", count_nodes / seconds, true});
+}
+
+//------------------------------------------------------------------------------
+void BenchPlayouts(const vector<ReversiState>& positions,
+                   vector<Metric>* metrics) {
+  const auto count = kCountPlayouts * positions.size();
+
+  double seconds = 0.0, seconds_batch = 0.0;
+
+  Random random(kSeed);
+
+  vector<ReversiBoard> boards;
+  vector<int32_t> winners(count);
+
+  for (const auto& position : positions) {
+    boards.insert(boards.end(), kCountPlayouts, position.ToBoard());
+  }
+
+  for (auto i = 0; i < kCountRepeats; ++i) {
+    auto start = Clock::now();
+
+    for (auto position : positions) {
+      for (auto j = 0; j < kCountPlayouts; ++j) {
+        winners[j] = position.Simulate(&random);
+      }
+    }
+
+    auto elapsed = SecondsSince(start);
+
+    seconds = (i == 0) ? elapsed : std::min(seconds, elapsed);
+
+    start = Clock::now();
+
+    ReversiGame::Simulate(boards.data(), count, &random, winners.data());
+
+    elapsed = SecondsSince(start);
+
+    seconds_batch = (i == 0) ? elapsed : std::min(seconds_batch, elapsed);
+  }
+
+  metrics->push_back({"playouts_per_second", count / seconds, true});
+  metrics->push_back(
+    {"batch_playouts_per_second", count / seconds_batch, true});
+}
+
+//------------------------------------------------------------------------------
+void BenchSearch(const vector<ReversiState>& positions,
+                 vector<Metric>* metrics) {
+  UctOptions options;
+
+  options.count_round = kCountRounds;
+  options.seed = kSeed;
+
+  double seconds = 0.0;
+  double bytes_per_node = 0.0;
+  int64_t count_round = 0;
+
+  for (auto i = 0; i < kCountRepeats; ++i) {
+    UpperConfidenceTree uct(options);
+
+    double elapsed = 0.0;
+    size_t count_bytes = 0;
+    uint64_t count_nodes = 0;
+
+    count_round = 0;
+
+    for (auto position : positions) {
+      shared_ptr<State> move(uct.Search(&position));
+
+      const auto& report = uct.GetReport();
+
+      elapsed += report.milliseconds / 1000.0;
+      count_round += report.count_round;
+      count_bytes = max(count_bytes, report.count_bytes);
+      count_nodes = max<uint64_t>(count_nodes, report.count_nodes);
+    }
+
+    seconds = (i == 0) ? elapsed : std::min(seconds, elapsed);
+
+    // Of the largest tree, the arenas keep their blocks between searches.
+    bytes_per_node = static_cast<double>(count_bytes) / count_nodes;
+  }
+
+  metrics->push_back({"search_iterations_per_second",
+                      count_round / seconds, true});
+  metrics->push_back({"search_bytes_per_node", bytes_per_node, false});
+}
+
+//------------------------------------------------------------------------------
+void WriteJson(const vector<Metric>& metrics, ostream* stream) {
+  *stream << "{" << endl << fixed << setprecision(2);
+
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    *stream << "  \"" << metrics[i].name << "\": " << metrics[i].value
+            << (i + 1 < metrics.size() ? "," : "") << endl;
+  }
+
+  *stream << "}" << endl;
+}
+
+//------------------------------------------------------------------------------
+// The metrics of a file written by WriteJson, only "name": number pairs are
+// looked for.
+bool ReadJson(const char* path, vector<pair<string, double>>* values) {
+  ifstream file(path);
+
+  if (!file) { return false; }
+
+  ostringstream text;
+
+  text << file.rdbuf();
+
+  const auto json = text.str();
+
+  for (auto begin = json.find('"'); begin != string::npos;
+       begin = json.find('"', begin)) {
+    const auto end = json.find('"', begin + 1);
+    const auto colon = json.find(':', end);
+
+    if (end == string::npos || colon == string::npos) { break; }
+
+    values->emplace_back(
+      json.substr(begin + 1, end - begin - 1),
+      strtod(json.c_str() + colon + 1, nullptr));
+
+    begin = json.find_first_of(",}", colon);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Print metric,baseline,current,change as CSV, return false if a metric got
+// worse by more than tolerance percent or a node count changed.
+bool Compare(const vector<Metric>& metrics,
+             const vector<pair<string, double>>& baseline, double tolerance) {
+  auto is_good = true;
+
+  cout << "metric,baseline,current,change_percent,verdict" << endl;
+
+  for (const auto& metric : metrics) {
+    auto it = std::find_if(baseline.begin(), baseline.end(),
+      [&metric](const pair<string, double>& value) {
+        return value.first == metric.name;
+      });
+
+    if (it == baseline.end()) {
+      cout << metric.name << ",," << metric.value << ",,new" << endl;
+
+      continue;
+    }
+
+    const auto change = (metric.value - it->second) / it->second * 100.0;
+    const auto gain = metric.is_higher_better ? change : -change;
+
+    string verdict = "ok";
+
+    if (metric.name == "perft_nodes") {
+      verdict = (metric.value == it->second) ? "ok" : "mismatch";
+    } else if (gain < -tolerance) {
+      verdict = "regression";
+    } else if (gain > tolerance) {
+      verdict = "improvement";
+    }
+
+    is_good = is_good && verdict != "regression" && verdict != "mismatch";
+
+    cout << metric.name << "," << it->second << "," << metric.value << ","
+         << change << "," << verdict << endl;
+  }
+
+  return is_good;
+}
+}  // namespace
+
+// ./a.out [--save path] [--compare path] [--tolerance percent]
+//
+// Measure move generation (perft over EnumValidMoves / MoveAt), playouts and
+// UpperConfidenceTree::Search on a fixed set of seeded positions and print
+// the results as JSON. --save writes them to path as a baseline, --compare
+// prints a CSV of the changes from the baseline at path and exits with 1 if
+// a speed dropped by more than tolerance (5) percent or a count changed.
+int main(int argc, char** argv) {
+  const char* path_save = nullptr;
+  const char* path_compare = nullptr;
+
+  double tolerance = 5.0;
+
+  for (auto i = 1; i + 1 < argc; i += 2) {
+    if (strcmp(argv[i], "--save") == 0) {
+      path_save = argv[i + 1];
+    } else if (strcmp(argv[i], "--compare") == 0) {
+      path_compare = argv[i + 1];
+    } else if (strcmp(argv[i], "--tolerance") == 0) {
+      tolerance = atof(argv[i + 1]);
+    }
+  }
+
+  if (argc % 2 == 0) {
+    cout << "usage: " << argv[0]
+         << " [--save path] [--compare path] [--tolerance percent]" << endl;
+
+    return 1;
+  }
+
+  vector<pair<string, double>> baseline;
+
+  if (path_compare != nullptr && !ReadJson(path_compare, &baseline)) {
+    cout << "can not read " << path_compare << endl;
+
+    return 1;
+  }
+
+  const auto positions = Positions();
+
+  vector<Metric> metrics;
+
+  BenchPerft(positions, &metrics);
+  BenchPlayouts(positions, &metrics);
+  BenchSearch(positions, &metrics);
+
+  WriteJson(metrics, &cout);
+
+  if (path_save != nullptr) {
+    ofstream file(path_save);
+
+    WriteJson(metrics, &file);
+
+    if (!file) {
+      cout << "can not write " << path_save << endl;
+
+      return 1;
+    }
+  }
+
+  if (path_compare != nullptr && !Compare(metrics, baseline, tolerance)) {
+    return 1;
+  }
+
+  return 0;
+}
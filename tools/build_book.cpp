@@ -0,0 +1,185 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../reversi/board.hpp"
+#include "../reversi/book.hpp"
+#include "../reversi/reversi.hpp"
+#include "../uct/uct.hpp"
+
+using std::atoi;
+using std::condition_variable;
+using std::cout;
+using std::deque;
+using std::endl;
+using std::max;
+using std::mutex;
+using std::pair;
+using std::sort;
+using std::thread;
+using std::unique_lock;
+using std::unordered_set;
+using std::vector;
+
+namespace {
+// Positions waiting for a search, and what the searches found. The openings
+// are searched breadth first, each thread with a search of its own.
+struct Builder {
+  int32_t                             count_plies;
+  int32_t                             count_round;
+  int32_t                             width;
+
+  mutex                               guard;
+  condition_variable                  condition;
+  deque<pair<ReversiBoard, int32_t>>  pending;
+  unordered_set<uint64_t>             keys;
+  vector<OpeningBook::Entry>          entries;
+  int32_t                             count_busy;
+  int32_t                             count_positions;
+};
+
+//------------------------------------------------------------------------------
+// Queue board at ply unless one of its symmetric positions is queued.
+void Push(Builder* builder, const ReversiBoard& board, int32_t ply) {
+  int32_t k;
+
+  if (builder->keys.insert(OpeningBook::KeyOf(board, &k)).second) {
+    builder->pending.emplace_back(board, ply);
+  }
+}
+
+//------------------------------------------------------------------------------
+void Work(Builder* builder) {
+  UctOptions options;
+
+  options.count_round = builder->count_round;
+  options.merge_symmetries = true;
+  options.prove = true;
+
+  Uct<ReversiGame> uct(options);
+
+  unique_lock<mutex> lock(builder->guard);
+
+  while (true) {
+    builder->condition.wait(lock, [builder]() {
+      return !builder->pending.empty() || builder->count_busy == 0;
+    });
+
+    if (builder->pending.empty()) { break; }
+
+    const auto board = builder->pending.front().first;
+    const auto ply = builder->pending.front().second;
+
+    builder->pending.pop_front();
+    builder->count_busy += 1;
+
+    lock.unlock();
+
+    uct.Search(board);
+
+    const auto& tree = uct.GetTree();
+    const auto& root = tree.NodeAt(0);
+
+    // Children by visits, the most visited first.
+    vector<pair<uint32_t, uint32_t>> children;
+
+    for (uint32_t i = 0; i < root.count_children; ++i) {
+      children.emplace_back(
+        tree.NodeAt(root.first_child + i).count_visits.load(),
+        root.first_child + i);
+    }
+
+    sort(children.rbegin(), children.rend());
+
+    lock.lock();
+
+    for (size_t i = 0; i < children.size(); ++i) {
+      const auto& node = tree.NodeAt(children[i].second);
+      const auto& child = tree.BoardAt(children[i].second);
+
+      if (children[i].first == 0) { continue; }
+
+      builder->entries.push_back(OpeningBook::EntryOf(
+        board, child, children[i].first,
+        node.count_wins.load() / children[i].first));
+
+      if (ply + 1 < builder->count_plies &&
+          static_cast<int32_t>(i) < builder->width &&
+          !ReversiGame::IsEnd(child)) {
+        Push(builder, child, ply + 1);
+      }
+    }
+
+    builder->count_busy -= 1;
+    builder->count_positions += 1;
+
+    if (builder->count_positions % 100 == 0) {
+      cout << builder->count_positions << " positions, "
+           << builder->pending.size() << " pending" << endl;
+    }
+
+    builder->condition.notify_all();
+  }
+}
+}  // namespace
+
+// ./a.out path [plies] [rounds] [width] [threads]
+//
+// Search the openings up to plies (10) deep, rounds (100000) per position,
+// following the width (2) most visited moves of each, on threads (all cores)
+// threads. Write the book to path.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    cout << "usage: " << argv[0]
+         << " path [plies] [rounds] [width] [threads]" << endl;
+
+    return 1;
+  }
+
+  Builder builder;
+
+  builder.count_plies = argc > 2 ? atoi(argv[2]) : 10;
+  builder.count_round = argc > 3 ? atoi(argv[3]) : 100000;
+  builder.width = argc > 4 ? atoi(argv[4]) : 2;
+  builder.count_busy = 0;
+  builder.count_positions = 0;
+
+  const int32_t count_threads = argc > 5
+    ? atoi(argv[5]) : max(1u, thread::hardware_concurrency());
+
+  const auto start = std::chrono::steady_clock::now();
+
+  Push(&builder, ReversiState().ToBoard(), 0);
+
+  vector<thread> threads;
+
+  for (int32_t i = 0; i < count_threads; ++i) {
+    threads.emplace_back(Work, &builder);
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (!OpeningBook::Write(argv[1], builder.entries)) {
+    cout << "can not write " << argv[1] << endl;
+
+    return 1;
+  }
+
+  const std::chrono::duration<double> seconds =
+    std::chrono::steady_clock::now() - start;
+
+  cout << builder.count_positions << " positions, "
+       << builder.entries.size() << " entries in " << seconds.count()
+       << " s" << endl;
+}
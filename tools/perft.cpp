@@ -0,0 +1,116 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "../reversi/perft.hpp"
+#include "../reversi/reversi.hpp"
+
+using std::atoi;
+using std::cout;
+using std::endl;
+using std::max;
+using std::strcmp;
+using std::strlen;
+using std::thread;
+
+namespace {
+// Paths from the opening, kOpeningCounts[d] for depth d.
+const uint64_t kOpeningCounts[] = {
+  1ull, 4ull, 12ull, 56ull, 244ull, 1396ull, 8200ull, 55092ull, 390216ull,
+  3005288ull, 24571284ull, 212258800ull, 1939886636ull,
+};
+
+const int32_t kCountOpeningCounts =
+  sizeof(kOpeningCounts) / sizeof(kOpeningCounts[0]);
+}  // namespace
+
+// ./a.out depth [--threads n] [--table megabytes] [--divide]
+//         [--board stones player]
+//
+// Count the move paths of depth moves from the opening, or from board,
+// 64 characters as ReversiState takes them (x black, o white, space empty)
+// with player x or o to move. threads defaults to all cores and table
+// (Perft::kDefaultTableSize) to 64, 0 for none. --divide prints the paths
+// below each first move. From the opening the count is checked against the
+// known one, a mismatch exits with 1.
+int main(int argc, char** argv) {
+  const auto depth = argc > 1 ? atoi(argv[1]) : 0;
+
+  int32_t count_threads = max(1u, thread::hardware_concurrency());
+  size_t table_size = Perft::kDefaultTableSize;
+  bool is_divided = false;
+
+  ReversiState state;
+  bool is_opening = true;
+
+  auto is_usage = (depth <= 0);
+
+  for (auto i = 2; i < argc && !is_usage; ++i) {
+    if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      count_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--table") == 0 && i + 1 < argc) {
+      table_size = static_cast<size_t>(atoi(argv[++i])) << 20;
+    } else if (strcmp(argv[i], "--divide") == 0) {
+      is_divided = true;
+    } else if (strcmp(argv[i], "--board") == 0 && i + 2 < argc &&
+               strlen(argv[i + 1]) == 64 &&
+               (argv[i + 2][0] == 'x' || argv[i + 2][0] == 'o')) {
+      state = ReversiState(argv[i + 1], argv[i + 2][0] == 'x'
+        ? ReversiState::Player::kBlack : ReversiState::Player::kWhite);
+      is_opening = false;
+      i += 2;
+    } else {
+      is_usage = true;
+    }
+  }
+
+  if (is_usage || count_threads <= 0) {
+    cout << "usage: " << argv[0] << " depth [--threads n] "
+         << "[--table megabytes] [--divide] [--board stones x|o]" << endl;
+
+    return 1;
+  }
+
+  Perft perft(count_threads, table_size);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  uint64_t count = 0;
+
+  if (is_divided) {
+    for (const auto& division : perft.Divide(state, depth)) {
+      if (division.first.x < 0) {
+        cout << "pass";
+      } else {
+        cout << division.first.x << static_cast<char>('A' + division.first.y);
+      }
+
+      cout << " " << division.second << endl;
+
+      count += division.second;
+    }
+  } else {
+    count = perft.Count(state, depth);
+  }
+
+  const std::chrono::duration<double> seconds =
+    std::chrono::steady_clock::now() - start;
+
+  cout << "depth " << depth << ": " << count << " paths in "
+       << seconds.count() << " s, " << count / seconds.count()
+       << " paths/s, " << perft.CountHits() << " table hits" << endl;
+
+  if (is_opening && depth < kCountOpeningCounts &&
+      count != kOpeningCounts[depth]) {
+    cout << "mismatch, the opening has " << kOpeningCounts[depth]
+         << " paths" << endl;
+
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,360 @@
+// Copyright 2016 iRonhead
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../reversi/bitboard.hpp"
+#include "../reversi/board.hpp"
+#include "../reversi/reversi.hpp"
+#include "../reversi/service.hpp"
+
+using std::atoi;
+using std::cerr;
+using std::endl;
+using std::fixed;
+using std::istringstream;
+using std::lock_guard;
+using std::max;
+using std::mutex;
+using std::ostringstream;
+using std::setprecision;
+using std::shared_ptr;
+using std::strcmp;
+using std::string;
+using std::thread;
+
+namespace {
+// Latencies are printed once per this many results.
+const int64_t kReportInterval = 100;
+
+// Bytes read from a client at once.
+const size_t kReadSize = 4096;
+
+// Latencies of all results so far.
+struct Latencies {
+  mutex     guard;
+  int64_t   count_results;
+  int64_t   count_late;
+  double    sum_queue_milliseconds;
+  double    sum_search_milliseconds;
+  double    max_queue_milliseconds;
+  double    max_search_milliseconds;
+};
+
+// A client, its requests are answered in the order they are done. The
+// descriptors are closed once the client is gone and all its requests are
+// answered.
+struct Client {
+  int   input;
+  int   output;
+  mutex guard;
+
+  ~Client();
+};
+
+//------------------------------------------------------------------------------
+Client::~Client() {
+  if (this->input > STDERR_FILENO) { close(this->input); }
+
+  if (this->output > STDERR_FILENO && this->output != this->input) {
+    close(this->output);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Write line to client, a client which is gone is ignored.
+void Write(Client* client, const string& line) {
+  lock_guard<mutex> lock(client->guard);
+
+  for (size_t i = 0; i < line.size();) {
+    const auto count =
+      write(client->output, line.data() + i, line.size() - i);
+
+    if (count < 0 && errno == EINTR) { continue; }
+
+    if (count <= 0) { return; }
+
+    i += count;
+  }
+}
+
+//------------------------------------------------------------------------------
+// The square played from board into child as reversi_game reads it (column
+// digit, row letter), "pass" if none is.
+string MoveOf(const ReversiBoard& board, const ReversiBoard& child) {
+  const auto stones = board.blacks | board.whites;
+  const auto move = (child.blacks | child.whites) & ~stones;
+
+  if (move == 0) { return "pass"; }
+
+  const auto index = Bitboard::IndexOfLowest(move);
+
+  ostringstream text;
+
+  text << index % 8 << static_cast<char>('A' + index / 8);
+
+  return text.str();
+}
+
+//------------------------------------------------------------------------------
+void Report(Latencies* latencies) {
+  const auto count =
+    static_cast<double>(max<int64_t>(latencies->count_results, 1));
+
+  cerr << fixed << setprecision(1) << latencies->count_results
+       << " results, " << latencies->count_late << " late, queue "
+       << latencies->sum_queue_milliseconds / count << " ms (max "
+       << latencies->max_queue_milliseconds << "), search "
+       << latencies->sum_search_milliseconds / count << " ms (max "
+       << latencies->max_search_milliseconds << ")" << endl;
+}
+
+//------------------------------------------------------------------------------
+// Answer request id of client with result, see main.
+void Answer(const shared_ptr<Client>& client, const string& id,
+            const ReversiBoard& board, const SearchResult& result,
+            Latencies* latencies) {
+  ostringstream text;
+
+  text << id;
+
+  if (result.is_end) {
+    text << " end";
+  } else {
+    text << " " << MoveOf(board, result.best) << fixed << setprecision(3)
+         << " " << result.value << " " << result.count_round
+         << setprecision(1) << " " << result.queue_milliseconds << " "
+         << result.search_milliseconds;
+
+    if (result.is_late) { text << " late"; }
+
+    if (result.is_solved) { text << " solved " << result.score; }
+  }
+
+  text << '\n';
+
+  Write(client.get(), text.str());
+
+  lock_guard<mutex> lock(latencies->guard);
+
+  latencies->count_results += 1;
+  latencies->count_late += result.is_late ? 1 : 0;
+  latencies->sum_queue_milliseconds += result.queue_milliseconds;
+  latencies->sum_search_milliseconds += result.search_milliseconds;
+  latencies->max_queue_milliseconds =
+    max(latencies->max_queue_milliseconds, result.queue_milliseconds);
+  latencies->max_search_milliseconds =
+    max(latencies->max_search_milliseconds, result.search_milliseconds);
+
+  if (latencies->count_results % kReportInterval == 0) {
+    Report(latencies);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parse line, "id rounds deadline stones player", into id and request.
+bool Parse(const string& line, string* id, SearchRequest* request) {
+  istringstream stream(line);
+
+  if (!(stream >> *id >> request->count_round >> request->deadline) ||
+      stream.get() != ' ' || request->count_round <= 0 ||
+      request->deadline < 0) {
+    return false;
+  }
+
+  char stones[65] = {0};
+  char player = 0;
+
+  if (!stream.read(stones, 64) || !(stream >> player) ||
+      (player != 'x' && player != 'o')) {
+    return false;
+  }
+
+  request->board = ReversiState(stones, player == 'x'
+    ? ReversiState::Player::kBlack : ReversiState::Player::kWhite).ToBoard();
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Submit the requests of client until it is gone, the results are written
+// back by the threads of service.
+void Serve(SearchService* service, shared_ptr<Client> client,
+           Latencies* latencies) {
+  string buffer;
+  char block[kReadSize];
+
+  while (true) {
+    const auto count = read(client->input, block, kReadSize);
+
+    if (count < 0 && errno == EINTR) { continue; }
+
+    if (count <= 0) { break; }
+
+    buffer.append(block, count);
+
+    for (auto end = buffer.find('\n'); end != string::npos;
+         end = buffer.find('\n')) {
+      const auto line = buffer.substr(0, end);
+
+      buffer.erase(0, end + 1);
+
+      string id;
+      SearchRequest request;
+
+      if (!Parse(line, &id, &request)) {
+        Write(client.get(), (id.empty() ? string("?") : id) + " error\n");
+
+        continue;
+      }
+
+      const auto board = request.board;
+
+      service->Submit(request, [client, id, board, latencies](
+          const SearchResult& result) {
+        Answer(client, id, board, result, latencies);
+      });
+    }
+  }
+}
+}  // namespace
+
+// ./a.out [--socket path] [--threads n] [--solve n]
+//
+// Search positions for many games at once on threads (all cores) threads,
+// see SearchService. Requests are read from clients of the Unix-domain
+// socket at path, or from stdin if there is none, one per line:
+//
+//   id rounds deadline stones player
+//
+// id is any word, deadline is in milliseconds (0 for none), stones are 64 as
+// ReversiState takes them (x black, o white, anything else empty) and player
+// is x or o. Each is answered on the same connection (stdout), in the order
+// they are done:
+//
+//   id move value rounds queue_ms search_ms [late] [solved score]
+//   id end
+//   id error
+//
+// Positions with at most solve (0) empty squares are solved exactly. The
+// latencies of all results are printed to stderr every 100 results, and at
+// the end of stdin.
+int main(int argc, char** argv) {
+  UctOptions options;
+
+  int32_t count_threads = max(1u, thread::hardware_concurrency());
+  const char* path = nullptr;
+
+  auto is_usage = false;
+
+  for (auto i = 1; i < argc && !is_usage; ++i) {
+    const auto has_value = i + 1 < argc;
+
+    if (strcmp(argv[i], "--socket") == 0 && has_value) {
+      path = argv[++i];
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      count_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--solve") == 0 && has_value) {
+      options.solve_depth = atoi(argv[++i]);
+    } else {
+      is_usage = true;
+    }
+  }
+
+  sockaddr_un address;
+
+  if (is_usage || count_threads <= 0 ||
+      (path != nullptr && strlen(path) >= sizeof(address.sun_path))) {
+    cerr << "usage: " << argv[0] << " [--socket path] [--threads n] "
+         << "[--solve n]" << endl;
+
+    return 1;
+  }
+
+  // Clients which go away leave their results unwritten.
+  std::signal(SIGPIPE, SIG_IGN);
+
+  Latencies latencies;
+
+  latencies.count_results = 0;
+  latencies.count_late = 0;
+  latencies.sum_queue_milliseconds = 0.0;
+  latencies.sum_search_milliseconds = 0.0;
+  latencies.max_queue_milliseconds = 0.0;
+  latencies.max_search_milliseconds = 0.0;
+
+  if (path == nullptr) {
+    shared_ptr<Client> client(new Client());
+
+    client->input = STDIN_FILENO;
+    client->output = STDOUT_FILENO;
+
+    {
+      SearchService service(options, count_threads);
+
+      Serve(&service, client, &latencies);
+    }
+
+    Report(&latencies);
+
+    return 0;
+  }
+
+  const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  memset(&address, 0, sizeof(address));
+
+  address.sun_family = AF_UNIX;
+
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+  unlink(path);
+
+  if (listener < 0 ||
+      bind(listener, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    cerr << "can not listen on " << path << ": " << strerror(errno) << endl;
+
+    return 1;
+  }
+
+  SearchService service(options, count_threads);
+
+  cerr << "listening on " << path << " with " << count_threads
+       << " threads" << endl;
+
+  // The clients are served until the process is killed.
+  while (true) {
+    const auto connection = accept(listener, nullptr, nullptr);
+
+    if (connection < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) { continue; }
+
+      cerr << "can not accept: " << strerror(errno) << endl;
+
+      // The readers of the clients still use the service.
+      std::_Exit(1);
+    }
+
+    shared_ptr<Client> client(new Client());
+
+    client->input = connection;
+    client->output = connection;
+
+    thread(Serve, &service, client, &latencies).detach();
+  }
+}
@@ -0,0 +1,414 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../reversi/reversi.hpp"
+#include "../uct/uct.hpp"
+
+using std::atof;
+using std::atoi;
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::getline;
+using std::istringstream;
+using std::log;
+using std::log10;
+using std::lock_guard;
+using std::max;
+using std::min;
+using std::mutex;
+using std::pow;
+using std::setprecision;
+using std::shared_ptr;
+using std::sqrt;
+using std::strcmp;
+using std::string;
+using std::thread;
+using std::unordered_set;
+using std::vector;
+
+namespace {
+// Results are printed once per this many games.
+const int32_t kReportInterval = 20;
+
+// The SPRT is not checked before this many games, the variance of fewer is
+// too far off.
+const int32_t kSprtMinGames = 100;
+
+// Scores within this far from 0 or 1 are clamped, their Elo is infinite.
+const double kScoreEpsilon = 1e-6;
+
+// What one side of the match plays with, parsed from "key=value,...":
+//
+//   rounds   UctOptions::count_round (10000)
+//   time     UctOptions::time_limit in ms, replaces rounds (0)
+//   threads  UctOptions::count_threads (1)
+//   tree     tree parallel threads instead of root parallel (0)
+//   reuse    UctOptions::reuse_tree (0)
+//   tt       UctOptions::transposition_table_size in MB (0)
+//   merge    UctOptions::merge_symmetries (0)
+//   solve    UctOptions::solve_depth (0)
+//   prove    UctOptions::prove (0)
+bool ParseEngine(const string& text, UctOptions* options) {
+  istringstream stream(text);
+  string pair;
+
+  while (getline(stream, pair, ',')) {
+    const auto equal = pair.find('=');
+
+    if (equal == string::npos) { return false; }
+
+    const auto key = pair.substr(0, equal);
+    const auto value = atoi(pair.c_str() + equal + 1);
+
+    if (key == "rounds") {
+      options->count_round = value;
+    } else if (key == "time") {
+      options->time_limit = value;
+      options->count_round = 0;
+    } else if (key == "threads") {
+      options->count_threads = max(value, 1);
+    } else if (key == "tree") {
+      options->parallelism = value ? UctOptions::kTree : UctOptions::kRoot;
+    } else if (key == "reuse") {
+      options->reuse_tree = (value != 0);
+    } else if (key == "tt") {
+      options->transposition_table_size = static_cast<size_t>(value) << 20;
+    } else if (key == "merge") {
+      options->merge_symmetries = (value != 0);
+    } else if (key == "solve") {
+      options->solve_depth = value;
+    } else if (key == "prove") {
+      options->prove = (value != 0);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// The positions plies moves into the game, one of each set of symmetric
+// ones, in the order of EnumValidMoves. Each is played twice with the
+// colours swapped, which makes up for the openings that favour one side.
+vector<ReversiState> Openings(int32_t plies) {
+  vector<ReversiState> openings(1);
+
+  for (auto ply = 0; ply < plies; ++ply) {
+    vector<ReversiState> children;
+    unordered_set<uint64_t> hashes;
+
+    for (const auto& opening : openings) {
+      const auto player = opening.CurrentPlayer();
+
+      for (const auto& move : opening.EnumValidMoves(player)) {
+        ReversiState child(opening);
+
+        child.MoveAt(move.x, move.y);
+
+        if (hashes.insert(child.Canonical().Hash()).second) {
+          children.push_back(child);
+        }
+      }
+    }
+
+    openings.swap(children);
+  }
+
+  return openings;
+}
+
+//------------------------------------------------------------------------------
+// Expected score of an Elo difference, and back.
+double ScoreOf(double elo) {
+  return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+//------------------------------------------------------------------------------
+double EloOf(double score) {
+  score = min(max(score, kScoreEpsilon), 1.0 - kScoreEpsilon);
+
+  return -400.0 * log10(1.0 / score - 1.0);
+}
+
+// Games won, drawn and lost by the first engine.
+struct Results {
+  int64_t count_wins;
+  int64_t count_draws;
+  int64_t count_losses;
+};
+
+//------------------------------------------------------------------------------
+int64_t CountGames(const Results& results) {
+  return results.count_wins + results.count_draws + results.count_losses;
+}
+
+//------------------------------------------------------------------------------
+double ScoreOf(const Results& results) {
+  return (results.count_wins + 0.5 * results.count_draws) /
+    CountGames(results);
+}
+
+//------------------------------------------------------------------------------
+// Variance of the score of one game.
+double VarianceOf(const Results& results) {
+  const auto score = ScoreOf(results);
+
+  return (results.count_wins * (1.0 - score) * (1.0 - score) +
+          results.count_draws * (0.5 - score) * (0.5 - score) +
+          results.count_losses * score * score) / CountGames(results);
+}
+
+//------------------------------------------------------------------------------
+// Log likelihood ratio of elo1 over elo0, the normal approximation of the
+// generalized SPRT: the mean score is normal with the observed variance.
+double LogLikelihoodRatio(const Results& results, double elo0, double elo1) {
+  const auto variance = VarianceOf(results);
+
+  if (variance <= 0.0) { return 0.0; }
+
+  const auto score0 = ScoreOf(elo0);
+  const auto score1 = ScoreOf(elo1);
+
+  return CountGames(results) * (score1 - score0) *
+    (2.0 * ScoreOf(results) - score0 - score1) / (2.0 * variance);
+}
+
+// The match, shared by the threads.
+struct Match {
+  UctOptions            engines[2];
+  vector<ReversiState>  openings;
+  int32_t               count_games;
+  uint64_t              seed;
+
+  // SPRT of H0: elo <= elo0 against H1: elo >= elo1, off if !is_sprt.
+  bool                  is_sprt;
+  double                elo0;
+  double                elo1;
+  double                lower_bound;
+  double                upper_bound;
+
+  std::atomic<int32_t>  next_game;
+  std::atomic<bool>     stop;
+
+  mutex                 guard;
+  Results               results;
+};
+
+//------------------------------------------------------------------------------
+void Report(const Match& match) {
+  const auto& results = match.results;
+  const auto count_games = CountGames(results);
+  const auto score = ScoreOf(results);
+
+  // 95% of the mean score, mapped to Elo.
+  const auto margin = 1.96 * sqrt(VarianceOf(results) / count_games);
+
+  cout << fixed << setprecision(1) << "games " << count_games << ": +"
+       << results.count_wins << " =" << results.count_draws << " -"
+       << results.count_losses << ", score " << 100.0 * score
+       << "%, elo " << EloOf(score) << " [" << EloOf(score - margin)
+       << ", " << EloOf(score + margin) << "]";
+
+  if (match.is_sprt) {
+    cout << setprecision(2) << ", llr "
+         << LogLikelihoodRatio(results, match.elo0, match.elo1) << " ["
+         << match.lower_bound << ", " << match.upper_bound << "]";
+  }
+
+  cout << endl;
+}
+
+//------------------------------------------------------------------------------
+// Play game index with engines[0] as black for an even index, from opening
+// index / 2. Return the winner.
+ReversiState::Player Play(Match* match, UpperConfidenceTree* engines[2],
+                          int32_t index) {
+  ReversiState state =
+    match->openings[(index / 2) % match->openings.size()];
+
+  const auto black = index % 2;
+
+  for (auto i = 0; i < 2; ++i) {
+    engines[i]->Seed(match->seed + 2 * index + i);
+  }
+
+  while (!state.IsEnd()) {
+    if (state.EnumValidMoves(state.CurrentPlayer()).empty()) {
+      state.MoveAt(-1, -1);
+
+      continue;
+    }
+
+    const auto side = (state.CurrentPlayer() == ReversiState::Player::kBlack)
+      ? black : 1 - black;
+
+    shared_ptr<State> move(engines[side]->Search(&state));
+
+    state = *dynamic_cast<ReversiState*>(move.get());
+  }
+
+  return state.Winner();
+}
+
+//------------------------------------------------------------------------------
+void Work(Match* match) {
+  UpperConfidenceTree engine0(match->engines[0]), engine1(match->engines[1]);
+  UpperConfidenceTree* engines[2] = {&engine0, &engine1};
+
+  while (!match->stop.load()) {
+    const auto index = match->next_game++;
+
+    if (index >= match->count_games) { break; }
+
+    const auto winner = Play(match, engines, index);
+
+    // Black is engines[0] in even games.
+    const auto black = (index % 2 == 0);
+
+    lock_guard<mutex> lock(match->guard);
+
+    auto& results = match->results;
+
+    if (winner == ReversiState::Player::kDraw) {
+      results.count_draws += 1;
+    } else if ((winner == ReversiState::Player::kBlack) == black) {
+      results.count_wins += 1;
+    } else {
+      results.count_losses += 1;
+    }
+
+    if (match->is_sprt && CountGames(results) >= kSprtMinGames) {
+      const auto llr = LogLikelihoodRatio(results, match->elo0, match->elo1);
+
+      if (llr <= match->lower_bound || llr >= match->upper_bound) {
+        match->stop.store(true);
+      }
+    }
+
+    if (CountGames(results) % kReportInterval == 0) {
+      Report(*match);
+    }
+  }
+}
+}  // namespace
+
+// ./a.out engine0 engine1 [--games n] [--threads n] [--plies n]
+//         [--sprt elo0 elo1] [--alpha a] [--beta b] [--seed n]
+//
+// Play games (1000) of engine0 against engine1, each "key=value,..." (see
+// ParseEngine), on threads (all cores) games at a time. Game 2i and 2i+1
+// start from the same opening, plies (4) moves deep, with the colours
+// swapped. Wins, draws, losses and Elo are of engine0, with a 95% interval.
+// With --sprt the match stops once H0 (elo <= elo0) or H1 (elo >= elo1) is
+// accepted at error rates alpha and beta (0.05).
+int main(int argc, char** argv) {
+  Match match;
+
+  match.count_games = 1000;
+  match.seed = 2016;
+  match.is_sprt = false;
+  match.elo0 = 0.0;
+  match.elo1 = 0.0;
+  match.next_game = 0;
+  match.stop = false;
+  match.results = Results{0, 0, 0};
+
+  int32_t count_threads = max(1u, thread::hardware_concurrency());
+  int32_t plies = 4;
+  double alpha = 0.05, beta = 0.05;
+
+  auto is_usage = argc < 3 ||
+    !ParseEngine(argv[1], &match.engines[0]) ||
+    !ParseEngine(argv[2], &match.engines[1]);
+
+  for (auto i = 3; i < argc && !is_usage; ++i) {
+    const auto has_value = i + 1 < argc;
+
+    if (strcmp(argv[i], "--games") == 0 && has_value) {
+      match.count_games = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      count_threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--plies") == 0 && has_value) {
+      plies = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--sprt") == 0 && i + 2 < argc) {
+      match.is_sprt = true;
+      match.elo0 = atof(argv[++i]);
+      match.elo1 = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--alpha") == 0 && has_value) {
+      alpha = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--beta") == 0 && has_value) {
+      beta = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      match.seed = static_cast<uint64_t>(atoi(argv[++i]));
+    } else {
+      is_usage = true;
+    }
+  }
+
+  if (is_usage || match.count_games <= 0 || count_threads <= 0 ||
+      plies < 0 || (match.is_sprt && match.elo0 >= match.elo1)) {
+    cout << "usage: " << argv[0] << " engine0 engine1 [--games n] "
+         << "[--threads n] [--plies n] [--sprt elo0 elo1] [--alpha a] "
+         << "[--beta b] [--seed n]" << endl
+         << "  engine: key=value,... of rounds, time, threads, tree, "
+         << "reuse, tt, merge, solve, prove" << endl;
+
+    return 1;
+  }
+
+  match.lower_bound = log(beta / (1.0 - alpha));
+  match.upper_bound = log((1.0 - beta) / alpha);
+  match.openings = Openings(plies);
+
+  cout << match.openings.size() << " openings, " << match.count_games
+       << " games on " << count_threads << " threads" << endl;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  vector<thread> threads;
+
+  for (auto i = 0; i < count_threads; ++i) {
+    threads.emplace_back(Work, &match);
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const std::chrono::duration<double> seconds =
+    std::chrono::steady_clock::now() - start;
+
+  // The last report may have been printed already.
+  if (CountGames(match.results) % kReportInterval != 0) {
+    Report(match);
+  }
+
+  if (match.is_sprt) {
+    const auto llr =
+      LogLikelihoodRatio(match.results, match.elo0, match.elo1);
+
+    cout << (llr >= match.upper_bound ? "H1 accepted"
+             : llr <= match.lower_bound ? "H0 accepted" : "inconclusive")
+         << endl;
+  }
+
+  cout << setprecision(1) << seconds.count() << " s" << endl;
+
+  return 0;
+}
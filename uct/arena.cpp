@@ -0,0 +1,118 @@
+// Copyright 2016 iRonhead
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include "arena.hpp"
+
+using std::bad_alloc;
+using std::free;
+using std::malloc;
+using std::max;
+
+namespace {
+const size_t kHugePageSize = 2 * 1024 * 1024;
+}  // namespace
+
+//------------------------------------------------------------------------------
+Arena::Arena(size_t block_size, bool huge_pages) : block_size_(block_size),
+    huge_pages_(huge_pages), blocks_(nullptr), head_(nullptr), tail_(nullptr),
+    bytes_allocated_(0), bytes_reserved_(0) {
+  if (huge_pages) {
+    this->block_size_ =
+      (block_size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  }
+}
+
+//------------------------------------------------------------------------------
+Arena::~Arena() {
+  while (this->blocks_ != nullptr) {
+    auto block = this->blocks_;
+
+    this->blocks_ = block->next;
+
+    this->FreeBlock(block);
+  }
+}
+
+//------------------------------------------------------------------------------
+void Arena::Reset() {
+  if (this->blocks_ == nullptr) { return; }
+
+  // Blocks are pushed at the front, the first block is the last one.
+  while (this->blocks_->next != nullptr) {
+    auto block = this->blocks_;
+
+    this->blocks_ = block->next;
+
+    this->FreeBlock(block);
+  }
+
+  this->head_ = reinterpret_cast<uint8_t*>(this->blocks_ + 1);
+  this->tail_ = reinterpret_cast<uint8_t*>(this->blocks_) + this->blocks_->size;
+  this->bytes_allocated_ = 0;
+  this->bytes_reserved_ = this->blocks_->size;
+}
+
+//------------------------------------------------------------------------------
+size_t Arena::BytesAllocated() const {
+  return this->bytes_allocated_;
+}
+
+//------------------------------------------------------------------------------
+size_t Arena::BytesReserved() const {
+  return this->bytes_reserved_;
+}
+
+//------------------------------------------------------------------------------
+void* Arena::AllocateSlow(size_t size, size_t alignment) {
+  // Oversized requests get a block of their own.
+  auto block = this->NewBlock(
+    max(this->block_size_, sizeof(Block) + size + alignment));
+
+  block->next = this->blocks_;
+
+  this->blocks_ = block;
+  this->head_ = reinterpret_cast<uint8_t*>(block + 1);
+  this->tail_ = reinterpret_cast<uint8_t*>(block) + block->size;
+
+  return this->Allocate(size, alignment);
+}
+
+//------------------------------------------------------------------------------
+Arena::Block* Arena::NewBlock(size_t size) {
+  void* memory = nullptr;
+
+  if (this->huge_pages_) {
+    size = (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+
+    if (posix_memalign(&memory, kHugePageSize, size) != 0) {
+      memory = nullptr;
+    }
+
+#ifdef MADV_HUGEPAGE
+    if (memory != nullptr) {
+      madvise(memory, size, MADV_HUGEPAGE);
+    }
+#endif  // MADV_HUGEPAGE
+  } else {
+    memory = malloc(size);
+  }
+
+  if (memory == nullptr) { throw bad_alloc(); }
+
+  auto block = static_cast<Block*>(memory);
+
+  block->next = nullptr;
+  block->size = size;
+
+  this->bytes_reserved_ += size;
+
+  return block;
+}
+
+//------------------------------------------------------------------------------
+void Arena::FreeBlock(Block* block) {
+  free(block);
+}
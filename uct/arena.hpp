@@ -0,0 +1,81 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_ARENA_H__
+#define REVERSI_ARENA_H__
+
+#include <cstddef>
+#include <cstdint>
+
+// A bump allocator for search trees. Memory is handed out from big blocks and
+// never freed one by one, Reset() / ~Arena() drop everything at once without
+// running any destructor. Objects put into an arena must be trivially
+// destructible (or must not care that their destructors are skipped).
+class Arena {
+ public:
+  static const size_t kDefaultBlockSize = 2 * 1024 * 1024;
+
+ public:
+  // With huge_pages, blocks are aligned to 2MB and advised to be backed by
+  // transparent huge pages (Linux only, silently ignored elsewhere).
+  explicit Arena(
+    size_t block_size = kDefaultBlockSize, bool huge_pages = false);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* Allocate(size_t size, size_t alignment);
+
+  template <typename T>
+  T* Allocate(size_t count = 1);
+
+  // Release all the memory but the first block, which is kept for reuse.
+  void Reset();
+
+  // Bytes handed out by Allocate.
+  size_t BytesAllocated() const;
+
+  // Bytes held in blocks.
+  size_t BytesReserved() const;
+
+ private:
+  struct Block {
+    Block*  next;
+    size_t  size;
+  };
+
+  void* AllocateSlow(size_t size, size_t alignment);
+  Block* NewBlock(size_t size);
+  void FreeBlock(Block* block);
+
+  size_t    block_size_;
+  bool      huge_pages_;
+  Block*    blocks_;
+  uint8_t*  head_;
+  uint8_t*  tail_;
+  size_t    bytes_allocated_;
+  size_t    bytes_reserved_;
+};
+
+//------------------------------------------------------------------------------
+inline void* Arena::Allocate(size_t size, size_t alignment) {
+  auto address = reinterpret_cast<uintptr_t>(this->head_);
+  auto aligned = (address + alignment - 1) & ~(alignment - 1);
+  auto head = reinterpret_cast<uint8_t*>(aligned) + size;
+
+  if (head > this->tail_ || this->head_ == nullptr) {
+    return this->AllocateSlow(size, alignment);
+  }
+
+  this->head_ = head;
+  this->bytes_allocated_ += size;
+
+  return reinterpret_cast<void*>(aligned);
+}
+
+//------------------------------------------------------------------------------
+template <typename T>
+inline T* Arena::Allocate(size_t count) {
+  return static_cast<T*>(this->Allocate(sizeof(T) * count, alignof(T)));
+}
+
+#endif  // REVERSI_ARENA_H__
@@ -0,0 +1,15 @@
+// Copyright 2016 iRonhead
+#include <atomic>
+#include <chrono>
+#include "random.hpp"
+
+//------------------------------------------------------------------------------
+uint64_t Random::ClockSeed() {
+  // Calls within one tick of the clock still differ.
+  static std::atomic<uint64_t> count_calls(0);
+
+  const auto ticks = static_cast<uint64_t>(
+    std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+  return ticks ^ (count_calls.fetch_add(1) * 0x9e3779b97f4a7c15ull);
+}
@@ -0,0 +1,106 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_RANDOM_H__
+#define REVERSI_RANDOM_H__
+
+#include <cstdint>
+#include "stats.hpp"
+
+// xoshiro256** (Blackman & Vigna), the random numbers of the playouts. It is
+// a few shifts and one multiply per number and keeps its state in the object,
+// so each search thread has one of its own: no lock, no shared cache line,
+// and the same seed replays the same search.
+class Random {
+ public:
+  // The same seed gives the same numbers. The state is filled from seed by
+  // SplitMix64, close seeds give unrelated streams.
+  explicit Random(uint64_t seed);
+
+  void Seed(uint64_t seed);
+
+  uint64_t Next();
+
+  // Uniform in [0, bound), bound must not be 0. Lemire's multiply and shift,
+  // rejecting the few low products which would bias the result.
+  uint32_t Below(uint32_t bound);
+
+  // Calls of Below, counted by UCT_STATS builds only.
+  uint64_t CountDraws() const;
+
+  // A different seed on each call, from the clock, for searches which are not
+  // asked to be reproducible.
+  static uint64_t ClockSeed();
+
+ private:
+  static uint64_t Rotate(uint64_t x, int32_t k);
+
+  uint64_t state_[4];
+  uint64_t count_draws_;
+};
+
+//------------------------------------------------------------------------------
+inline Random::Random(uint64_t seed) : count_draws_(0) {
+  this->Seed(seed);
+}
+
+//------------------------------------------------------------------------------
+inline void Random::Seed(uint64_t seed) {
+  for (auto& state : this->state_) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    state = z ^ (z >> 31);
+  }
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Random::Rotate(uint64_t x, int32_t k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Random::Next() {
+  auto s = this->state_;
+
+  const uint64_t result = Random::Rotate(s[1] * 5, 7) * 9;
+  const uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = Random::Rotate(s[3], 45);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+inline uint32_t Random::Below(uint32_t bound) {
+  UCT_STAT(this->count_draws_ += 1);
+
+  // The high 32 bits of a 32 x 32 bit product are uniform in [0, bound) once
+  // the low 32 bits are out of the 2^32 % bound values which come up once
+  // more often than the others.
+  uint64_t product =
+    static_cast<uint64_t>(static_cast<uint32_t>(this->Next() >> 32)) * bound;
+
+  if (static_cast<uint32_t>(product) < bound) {
+    const uint32_t threshold = (0u - bound) % bound;
+
+    while (static_cast<uint32_t>(product) < threshold) {
+      product = static_cast<uint64_t>(
+        static_cast<uint32_t>(this->Next() >> 32)) * bound;
+    }
+  }
+
+  return static_cast<uint32_t>(product >> 32);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t Random::CountDraws() const {
+  return this->count_draws_;
+}
+
+#endif  // REVERSI_RANDOM_H__
@@ -1,23 +1,13 @@
 // Copyright 2016 iRonhead
-#include <algorithm>
 #include <cassert>
-#include <limits>
 #include "state.hpp"
 
-using std::max_element;
-using std::numeric_limits;
-
 //------------------------------------------------------------------------------
-State::State() : count_wins_(0.0f), count_visits_(0.0f), parent_(nullptr),
-    value_(numeric_limits<float>::max()), type_(State::Type::kUnknown) {
+State::State() : type_(State::Type::kUnknown) {
 }
 
 //------------------------------------------------------------------------------
 State::~State() {
-  // Assume everyone is in heap.
-  for (auto child : this->children_) {
-    delete child;
-  }
 }
 
 //------------------------------------------------------------------------------
@@ -27,62 +17,50 @@ bool State::IsNormal() { return true; }
 bool State::IsEnd() { return true; }
 
 //------------------------------------------------------------------------------
-State* State::BestMove() const {
-  auto best = max_element(
-    this->children_.begin(),
-    this->children_.end(),
-    [](const State* a, const State* b) -> bool {
-      return a->count_visits_ < b->count_visits_;
-    });
-
-  return (*best)->Clone();
-}
+bool State::IsSame(const State& that) const { return false; }
 
 //------------------------------------------------------------------------------
-State* State::Clone() const {
-  return nullptr;
-}
+uint64_t State::Hash() const { return 0; }
 
 //------------------------------------------------------------------------------
-State* State::Select() {
-  // If there are no more moves, return this.
-  // If there are no children, return this to expand.
-  if (this->IsEnd() || this->children_.empty()) { return this; }
-
-  auto selected = max_element(
-    this->children_.begin(),
-    this->children_.end(),
-    [](const State* a, const State* b) -> bool {
-      return a->value_ < b->value_;
-    });
-
-  return (*selected)->Select();
+State* State::Clone(Arena* arena) const {
+  return nullptr;
 }
 
 //------------------------------------------------------------------------------
-State* State::Expand() {
+int32_t State::Expand(Arena* arena, State** children) {
   // Expand only when this is normal (not an end).
   assert(this->IsNormal());
 
-  // Expand only when there are no children.
-  assert(this->children_.empty());
-
-  return nullptr;
+  return 0;
 }
 
 //------------------------------------------------------------------------------
-int32_t State::Simulate() {
+int32_t State::Simulate(Random* random) {
   return -1;
 }
 
 //------------------------------------------------------------------------------
-void State::Backpropagate(int32_t winner) {
+float State::Reward(int32_t winner) const {
+  return 0.0f;
 }
 
 //------------------------------------------------------------------------------
-void State::Inspect() const {
+int32_t State::Outcome() {
+  // The playout of an end is the end, nothing is drawn.
+  Random random(1);
+
+  const auto reward = this->Reward(this->Simulate(&random));
+
+  return reward >= 1.0f ? 1 : reward <= 0.0f ? -1 : 0;
 }
 
 //------------------------------------------------------------------------------
-void State::InspectValue() const {
+bool State::Solve(
+    int32_t depth, Arena* arena, State** best, int32_t* score) const {
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void State::Inspect() const {
 }
@@ -3,34 +3,134 @@
 #define REVERSI_STATE_H__
 
 #include <cstdint>
-#include <vector>
+#include "arena.hpp"
+#include "random.hpp"
 
+// A position of a game. The search statistics are kept by the tree which
+// holds the states, see Tree and UpperConfidenceTree.
 class State {
  public:
   enum class Type { kUnknown, kNormal, kEnd };
 
+  // Upper bound of the number of children of a state.
+  static const int32_t kMaxChildren = 64;
+
  public:
   State();
   virtual ~State() = 0;
 
   virtual bool IsNormal();
   virtual bool IsEnd();
-  virtual State* BestMove() const;
-  virtual State* Clone() const;
-  virtual State* Select();
-  virtual State* Expand();
-  virtual int32_t Simulate();
-  virtual void Backpropagate(int32_t winner);
+
+  // True if that is the same position. Searches carry subtrees over only
+  // between same states, the default never matches.
+  virtual bool IsSame(const State& that) const;
+
+  // Hash of the position for transposition tables, 0 if it is not hashed.
+  virtual uint64_t Hash() const;
+
+  // Clone into arena, or into heap if arena is nullptr.
+  virtual State* Clone(Arena* arena = nullptr) const;
+
+  // Put the states one move away from this one into children, clones in
+  // arena, and return how many there are.
+  virtual int32_t Expand(Arena* arena, State** children);
+
+  // Play to the end with moves drawn from random and return the winner.
+  virtual int32_t Simulate(Random* random);
+
+  // How much the player who moved into this state earns when winner wins.
+  virtual float Reward(int32_t winner) const;
+
+  // Result of an end for the player who moved into this state, 1 for a win,
+  // -1 for a loss and 0 for a draw. The default goes by the reward of the
+  // playout, 1 a win and 0 a loss, a game with other rewards for draws must
+  // override it.
+  virtual int32_t Outcome();
+
+  // If this state has at most depth moves left, put its best child (a clone
+  // in arena) into best, the exact score of the player to move into score
+  // and return true. The default solves nothing.
+  virtual bool Solve(
+    int32_t depth, Arena* arena, State** best, int32_t* score) const;
+
   virtual void Inspect() const;
-  virtual void InspectValue() const;
 
  protected:
-  Type                type_;
-  float               value_;
-  float               count_wins_;
-  float               count_visits_;
-  State*              parent_;
-  std::vector<State*> children_;
+  Type type_;
 };
 
+// Game traits over State for Uct, every call is dispatched through the
+// virtual functions of the states. Boards are clones in the search arena.
+class StateGame {
+ public:
+  typedef State* Board;
+
+  static const int32_t kMaxChildren = State::kMaxChildren;
+
+  static Board Clone(const Board& board, Arena* arena);
+  static bool IsEnd(const Board& board);
+  static bool IsSame(const Board& a, const Board& b);
+  static uint64_t Hash(const Board& board);
+  static int32_t Expand(const Board& board, Arena* arena, Board* children);
+  static int32_t Simulate(const Board& board, Random* random);
+  static float Reward(const Board& board, int32_t winner);
+  static int32_t Outcome(const Board& board);
+  static bool Solve(const Board& board, int32_t depth, Arena* arena,
+                    Board* best, int32_t* score);
+  static void Inspect(const Board& board);
+};
+
+//------------------------------------------------------------------------------
+inline StateGame::Board StateGame::Clone(const Board& board, Arena* arena) {
+  return board->Clone(arena);
+}
+
+//------------------------------------------------------------------------------
+inline bool StateGame::IsEnd(const Board& board) {
+  return board->IsEnd();
+}
+
+//------------------------------------------------------------------------------
+inline bool StateGame::IsSame(const Board& a, const Board& b) {
+  return a->IsSame(*b);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t StateGame::Hash(const Board& board) {
+  return board->Hash();
+}
+
+//------------------------------------------------------------------------------
+inline int32_t StateGame::Expand(
+    const Board& board, Arena* arena, Board* children) {
+  return board->Expand(arena, children);
+}
+
+//------------------------------------------------------------------------------
+inline int32_t StateGame::Simulate(const Board& board, Random* random) {
+  return board->Simulate(random);
+}
+
+//------------------------------------------------------------------------------
+inline float StateGame::Reward(const Board& board, int32_t winner) {
+  return board->Reward(winner);
+}
+
+//------------------------------------------------------------------------------
+inline int32_t StateGame::Outcome(const Board& board) {
+  return board->Outcome();
+}
+
+//------------------------------------------------------------------------------
+inline bool StateGame::Solve(const Board& board, int32_t depth, Arena* arena,
+                             Board* best, int32_t* score) {
+  return board->Solve(depth, arena, best, score);
+}
+
+//------------------------------------------------------------------------------
+inline void StateGame::Inspect(const Board& board) {
+  board->Inspect();
+}
+
 #endif  // REVERSI_STATE_H__
@@ -0,0 +1,67 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_STATS_H__
+#define REVERSI_STATS_H__
+
+#include <algorithm>
+#include <cstdint>
+
+// Counters of where a search spends its time, see UctStats. They cost a few
+// clock reads per round, so they are only collected by builds with
+// -DUCT_STATS (make STATS=1). Elsewhere UCT_STAT(statement) is nothing and
+// UctStats stays all zeros.
+#ifdef UCT_STATS
+#define UCT_STAT(statement) statement
+#else
+#define UCT_STAT(statement)
+#endif  // UCT_STATS
+
+// What the rounds of a search did, summed over all threads.
+struct UctStats {
+  uint64_t  count_iterations;
+
+  // Nodes walked through from the root by Select, the root not counted.
+  uint64_t  sum_select_depths;
+  uint32_t  max_select_depth;
+
+  // Children allocated by Expand, and moves played by the playouts (the
+  // moves drawn from Random, passes are not drawn).
+  uint64_t  count_nodes_allocated;
+  uint64_t  count_playout_plies;
+
+  // Thread time in each phase of the rounds.
+  uint64_t  nanoseconds_select;
+  uint64_t  nanoseconds_expand;
+  uint64_t  nanoseconds_simulate;
+  uint64_t  nanoseconds_backpropagate;
+
+  UctStats() : count_iterations(0), sum_select_depths(0),
+      max_select_depth(0), count_nodes_allocated(0), count_playout_plies(0),
+      nanoseconds_select(0), nanoseconds_expand(0), nanoseconds_simulate(0),
+      nanoseconds_backpropagate(0) {}
+
+  double AverageSelectDepth() const;
+
+  void Add(const UctStats& that);
+};
+
+//------------------------------------------------------------------------------
+inline double UctStats::AverageSelectDepth() const {
+  return this->count_iterations == 0 ? 0.0
+    : static_cast<double>(this->sum_select_depths) / this->count_iterations;
+}
+
+//------------------------------------------------------------------------------
+inline void UctStats::Add(const UctStats& that) {
+  this->count_iterations += that.count_iterations;
+  this->sum_select_depths += that.sum_select_depths;
+  this->max_select_depth =
+    std::max(this->max_select_depth, that.max_select_depth);
+  this->count_nodes_allocated += that.count_nodes_allocated;
+  this->count_playout_plies += that.count_playout_plies;
+  this->nanoseconds_select += that.nanoseconds_select;
+  this->nanoseconds_expand += that.nanoseconds_expand;
+  this->nanoseconds_simulate += that.nanoseconds_simulate;
+  this->nanoseconds_backpropagate += that.nanoseconds_backpropagate;
+}
+
+#endif  // REVERSI_STATS_H__
@@ -0,0 +1,56 @@
+// Copyright 2016 iRonhead
+#include <cstdlib>
+#include <new>
+#include "transposition.hpp"
+
+using std::bad_alloc;
+using std::free;
+
+//------------------------------------------------------------------------------
+TranspositionTable::TranspositionTable(size_t size)
+    : buckets_(nullptr), mask_(0), generation_(1) {
+  size_t count_buckets = 1;
+
+  while (count_buckets * 2 * sizeof(Bucket) <= size) {
+    count_buckets *= 2;
+  }
+
+  void* memory = nullptr;
+
+  if (posix_memalign(&memory, alignof(Bucket), count_buckets * sizeof(Bucket))
+      != 0) {
+    throw bad_alloc();
+  }
+
+  this->buckets_ = new (memory) Bucket[count_buckets];
+  this->mask_ = count_buckets - 1;
+
+  this->Clear();
+}
+
+//------------------------------------------------------------------------------
+TranspositionTable::~TranspositionTable() {
+  free(this->buckets_);
+}
+
+//------------------------------------------------------------------------------
+void TranspositionTable::Age() {
+  // Generation 0 is left to empty entries.
+  this->generation_ = this->generation_ % 0xff + 1;
+}
+
+//------------------------------------------------------------------------------
+void TranspositionTable::Clear() {
+  for (size_t i = 0; i <= this->mask_; ++i) {
+    for (auto& entry : this->buckets_[i].entries) {
+      entry.key.store(0, std::memory_order_relaxed);
+      entry.count_visits.store(0, std::memory_order_relaxed);
+      entry.count_wins.store(0.0f, std::memory_order_relaxed);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+size_t TranspositionTable::CountEntries() const {
+  return (this->mask_ + 1) * kBucketSize;
+}
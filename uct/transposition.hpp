@@ -0,0 +1,121 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_TRANSPOSITION_H__
+#define REVERSI_TRANSPOSITION_H__
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Search statistics of positions keyed by their hashes, shared by all nodes
+// of the same position however the moves were ordered to reach it.
+//
+// The table is a power of 2 of buckets, each one cache line of 4 entries. A
+// position can only be in the bucket picked by the low bits of its hash. When
+// the bucket is full, a new position takes over an entry of an older search
+// or else the entry with the fewest visits. Entries may be lost or (rarely,
+// between threads) mixed up, the table is a hint and never the only copy of
+// the statistics.
+class TranspositionTable {
+ public:
+  struct Entry {
+    // The hash with its top byte replaced by the generation of the search
+    // which stored it, 56 bits are still plenty to tell positions apart. 0
+    // for an empty entry.
+    std::atomic<uint64_t> key;
+    std::atomic<uint32_t> count_visits;
+    std::atomic<float>    count_wins;
+  };
+
+ public:
+  // Use at most size bytes, at least one bucket.
+  explicit TranspositionTable(size_t size);
+  ~TranspositionTable();
+
+  TranspositionTable(const TranspositionTable&) = delete;
+  TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+  // The entry of hash, nullptr if it is not there.
+  const Entry* Find(uint64_t hash) const;
+
+  // The entry of hash, replacing an entry of its bucket if it is not there.
+  Entry* Insert(uint64_t hash);
+
+  // Start a new generation, entries of the older ones are never found and
+  // are replaced first. Much cheaper than Clear.
+  void Age();
+
+  // Empty all entries.
+  void Clear();
+
+  // Number of entries.
+  size_t CountEntries() const;
+
+ private:
+  static const size_t kBucketSize = 4;
+  static const int32_t kGenerationShift = 56;
+  static const uint64_t kGenerationMask = 0xffull << kGenerationShift;
+
+  struct alignas(64) Bucket {
+    Entry entries[kBucketSize];
+  };
+
+  // The key stored for hash in this generation.
+  uint64_t KeyOf(uint64_t hash) const;
+
+  Bucket*   buckets_;
+  size_t    mask_;
+  uint64_t  generation_;
+};
+
+//------------------------------------------------------------------------------
+inline uint64_t TranspositionTable::KeyOf(uint64_t hash) const {
+  return (hash & ~kGenerationMask) | (this->generation_ << kGenerationShift);
+}
+
+//------------------------------------------------------------------------------
+inline const TranspositionTable::Entry* TranspositionTable::Find(
+    uint64_t hash) const {
+  const auto& bucket = this->buckets_[hash & this->mask_];
+  const auto key = this->KeyOf(hash);
+
+  for (const auto& entry : bucket.entries) {
+    if (entry.key.load(std::memory_order_relaxed) == key) { return &entry; }
+  }
+
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+inline TranspositionTable::Entry* TranspositionTable::Insert(uint64_t hash) {
+  auto& bucket = this->buckets_[hash & this->mask_];
+  const auto key = this->KeyOf(hash);
+
+  Entry* victim = nullptr;
+
+  auto victim_visits = std::numeric_limits<uint32_t>::max();
+
+  for (auto& entry : bucket.entries) {
+    const auto entry_key = entry.key.load(std::memory_order_relaxed);
+
+    if (entry_key == key) { return &entry; }
+
+    const auto is_current =
+      (entry_key >> kGenerationShift) == this->generation_;
+    const auto count_visits = is_current
+      ? entry.count_visits.load(std::memory_order_relaxed) : 0;
+
+    if (count_visits < victim_visits) {
+      victim = &entry;
+      victim_visits = count_visits;
+    }
+  }
+
+  victim->count_visits.store(0, std::memory_order_relaxed);
+  victim->count_wins.store(0.0f, std::memory_order_relaxed);
+  victim->key.store(key, std::memory_order_relaxed);
+
+  return victim;
+}
+
+#endif  // REVERSI_TRANSPOSITION_H__
@@ -0,0 +1,226 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_TREE_H__
+#define REVERSI_TREE_H__
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "arena.hpp"
+
+// Search statistics of one node. Nodes refer to each other with 32 bit
+// indices into their Tree, the children of a node are always contiguous.
+//
+// Threads may share a tree. The counters are atomics, parent never changes
+// once allocated, and first_child / count_children are written before
+// kExpanded is set (release) and read after it is seen (acquire).
+//
+// A proven node has a known result for the player who moved into it, see
+// UctOptions::prove. Proofs are only ever added.
+struct Node {
+  // Bits of flags.
+  static const uint16_t kEnd = 1;
+  static const uint16_t kExpanding = 2;
+  static const uint16_t kExpanded = 4;
+  static const uint16_t kProvenWin = 8;
+  static const uint16_t kProvenLoss = 16;
+  static const uint16_t kProvenDraw = 32;
+  static const uint16_t kProven = kProvenWin | kProvenLoss | kProvenDraw;
+
+  uint32_t              parent;
+  uint32_t              first_child;
+  uint16_t              count_children;
+  std::atomic<uint16_t> flags;
+  std::atomic<uint32_t> count_visits;
+  std::atomic<float>    count_wins;
+};
+
+// Nodes and their boards (the positions) in two separated arrays, so walking
+// the statistics during a search does not drag the boards into the cache.
+// With has_hashes, a third array keeps a hash per board. The arrays grow in
+// chunks taken from the arena of the tree. Allocate may be called by many
+// threads at once.
+template <typename Board>
+class Tree {
+ public:
+  static const uint32_t kNull = 0xffffffffu;
+
+ public:
+  explicit Tree(bool huge_pages = false, bool has_hashes = false);
+
+  Tree(const Tree&) = delete;
+  Tree& operator=(const Tree&) = delete;
+
+  // Allocate count contiguous nodes with their parent set to parent, return
+  // the index of the first one. Boards are left uninitialized, hashes are 0.
+  uint32_t Allocate(uint32_t count, uint32_t parent);
+
+  Node& NodeAt(uint32_t index);
+  const Node& NodeAt(uint32_t index) const;
+  Board& BoardAt(uint32_t index);
+  const Board& BoardAt(uint32_t index) const;
+
+  // Only with has_hashes.
+  uint64_t& HashAt(uint32_t index);
+  uint64_t HashAt(uint32_t index) const;
+
+  bool HasHashes() const;
+
+  // Drop all nodes and release the memory but the first block of the arena.
+  void Clear();
+
+  // Number of allocated nodes.
+  uint32_t CountNodes() const;
+
+  // Bytes held by the tree.
+  size_t CountBytes() const;
+
+ private:
+  static const uint32_t kChunkBits = 14;
+  static const uint32_t kChunkSize = 1u << kChunkBits;
+  static const uint32_t kChunkMask = kChunkSize - 1;
+
+  struct Chunk {
+    Node*     nodes;
+    Board*    boards;
+    uint64_t* hashes;
+  };
+
+  // Chunks are reserved up front, so a thread reading chunks_ never sees it
+  // move while another one appends.
+  std::vector<Chunk>    chunks_;
+  Arena                 arena_;
+  std::mutex            mutex_;
+  std::atomic<uint32_t> count_nodes_;
+  uint32_t              next_index_;
+  bool                  has_hashes_;
+};
+
+template <typename Board>
+const uint32_t Tree<Board>::kNull;
+
+//------------------------------------------------------------------------------
+template <typename Board>
+Tree<Board>::Tree(bool huge_pages, bool has_hashes)
+    : arena_(Arena::kDefaultBlockSize, huge_pages),
+      count_nodes_(0), next_index_(0), has_hashes_(has_hashes) {
+  this->chunks_.reserve((1ull << 32) >> kChunkBits);
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+uint32_t Tree<Board>::Allocate(uint32_t count, uint32_t parent) {
+  assert(count > 0 && count <= kChunkSize);
+
+  std::lock_guard<std::mutex> lock(this->mutex_);
+
+  // A run of children never crosses chunks.
+  if ((this->next_index_ & kChunkMask) + count > kChunkSize) {
+    this->next_index_ = (this->next_index_ + kChunkMask) & ~kChunkMask;
+  }
+
+  const auto last_chunk = (this->next_index_ + count - 1) >> kChunkBits;
+
+  while (last_chunk >= this->chunks_.size()) {
+    Chunk chunk;
+
+    chunk.nodes = this->arena_.Allocate<Node>(kChunkSize);
+    chunk.boards = this->arena_.Allocate<Board>(kChunkSize);
+    chunk.hashes = this->has_hashes_
+      ? this->arena_.Allocate<uint64_t>(kChunkSize) : nullptr;
+
+    this->chunks_.push_back(chunk);
+  }
+
+  const auto first = this->next_index_;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    auto& node = this->NodeAt(first + i);
+
+    node.parent = parent;
+    node.first_child = kNull;
+    node.count_children = 0;
+    node.flags.store(0, std::memory_order_relaxed);
+    node.count_visits.store(0, std::memory_order_relaxed);
+    node.count_wins.store(0.0f, std::memory_order_relaxed);
+
+    if (this->has_hashes_) {
+      this->HashAt(first + i) = 0;
+    }
+  }
+
+  this->next_index_ += count;
+
+  // Read without the lock by searches watching their node budget.
+  this->count_nodes_.store(
+    this->count_nodes_.load(std::memory_order_relaxed) + count,
+    std::memory_order_relaxed);
+
+  return first;
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline Node& Tree<Board>::NodeAt(uint32_t index) {
+  return this->chunks_[index >> kChunkBits].nodes[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline const Node& Tree<Board>::NodeAt(uint32_t index) const {
+  return this->chunks_[index >> kChunkBits].nodes[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline Board& Tree<Board>::BoardAt(uint32_t index) {
+  return this->chunks_[index >> kChunkBits].boards[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline const Board& Tree<Board>::BoardAt(uint32_t index) const {
+  return this->chunks_[index >> kChunkBits].boards[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline uint64_t& Tree<Board>::HashAt(uint32_t index) {
+  return this->chunks_[index >> kChunkBits].hashes[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+inline uint64_t Tree<Board>::HashAt(uint32_t index) const {
+  return this->chunks_[index >> kChunkBits].hashes[index & kChunkMask];
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+bool Tree<Board>::HasHashes() const {
+  return this->has_hashes_;
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+void Tree<Board>::Clear() {
+  this->chunks_.clear();
+  this->arena_.Reset();
+  this->count_nodes_.store(0, std::memory_order_relaxed);
+  this->next_index_ = 0;
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+uint32_t Tree<Board>::CountNodes() const {
+  return this->count_nodes_.load(std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+template <typename Board>
+size_t Tree<Board>::CountBytes() const {
+  return this->arena_.BytesReserved();
+}
+
+#endif  // REVERSI_TREE_H__
@@ -0,0 +1,18 @@
+// Copyright 2016 iRonhead
+#include <cmath>
+#include "ucb.hpp"
+
+using std::log;
+
+float Ucb::double_logs_[Ucb::kTableSize];
+
+const bool Ucb::is_initialized_ = Ucb::Initialize();
+
+//------------------------------------------------------------------------------
+bool Ucb::Initialize() {
+  for (uint32_t i = 0; i < Ucb::kTableSize; ++i) {
+    Ucb::double_logs_[i] = 2.0f * log(static_cast<float>(i));
+  }
+
+  return true;
+}
@@ -0,0 +1,51 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_UCB_H__
+#define REVERSI_UCB_H__
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// The UCB1 score of a child, computed only when a parent picks a child:
+//
+//   wins / visits + sqrt(2 * ln(parent visits) / visits)
+//
+// 2 * ln(n) comes from a table for small n, so picking a child costs one
+// division and one square root per visited sibling. Children never visited
+// score the highest.
+class Ucb {
+ public:
+  // 2 * ln(count_parent_visits), shared by all children of a parent.
+  static float DoubleLog(uint32_t count_parent_visits);
+
+  static float Value(float double_log, uint32_t count_visits, float count_wins);
+
+ private:
+  static const uint32_t kTableSize = 1u << 16;
+
+  static bool Initialize();
+
+  static float double_logs_[kTableSize];
+  static const bool is_initialized_;
+};
+
+//------------------------------------------------------------------------------
+inline float Ucb::DoubleLog(uint32_t count_parent_visits) {
+  if (count_parent_visits < Ucb::kTableSize) {
+    return Ucb::double_logs_[count_parent_visits];
+  }
+
+  return 2.0f * std::log(static_cast<float>(count_parent_visits));
+}
+
+//------------------------------------------------------------------------------
+inline float Ucb::Value(
+    float double_log, uint32_t count_visits, float count_wins) {
+  if (count_visits == 0) { return std::numeric_limits<float>::max(); }
+
+  const float visits = static_cast<float>(count_visits);
+
+  return count_wins / visits + std::sqrt(double_log / visits);
+}
+
+#endif  // REVERSI_UCB_H__
@@ -0,0 +1,1046 @@
+// Copyright 2016 iRonhead
+#ifndef REVERSI_UCT_INL_H__
+#define REVERSI_UCT_INL_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ucb.hpp"
+#include "uct.hpp"
+
+//------------------------------------------------------------------------------
+template <class Game>
+Uct<Game>::Worker::Worker(const UctOptions& options, uint64_t seed)
+    : arena(new Arena(Arena::kDefaultBlockSize, options.huge_pages)),
+      spare_arena(new Arena(Arena::kDefaultBlockSize, options.huge_pages)),
+      own_tree(new Tree<Board>(
+        options.huge_pages, options.transposition_table_size > 0)),
+      spare_tree(new Tree<Board>(
+        options.huge_pages, options.transposition_table_size > 0)),
+      tree(own_tree.get()), random(seed), count_round(0), count_probes(0),
+      count_transpositions(0), count_merged(0) {
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+Uct<Game>::Uct(const UctOptions& options) : options_(options),
+    is_shared_(options.parallelism == UctOptions::kTree &&
+               options.count_threads > 1),
+    has_pondered_(false), stop_(false), ponder_arena_(kRootArenaSize) {
+  assert(options.count_threads > 0);
+  assert(options.virtual_loss > 0);
+
+  const auto seed = options.seed != 0 ? options.seed : Random::ClockSeed();
+
+  for (int32_t i = 0; i < options.count_threads; ++i) {
+    this->workers_.emplace_back(new Worker(options, seed + i));
+  }
+
+  if (this->is_shared_) {
+    for (auto& worker : this->workers_) {
+      worker->tree = this->workers_[0]->own_tree.get();
+    }
+  }
+
+  if (options.transposition_table_size > 0) {
+    this->transpositions_.reset(
+      new TranspositionTable(options.transposition_table_size));
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+Uct<Game>::Uct(int32_t count_round, bool huge_pages)
+    : Uct([=]() {
+        UctOptions options;
+
+        options.count_round = count_round;
+        options.huge_pages = huge_pages;
+
+        return options;
+      }()) {
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+Uct<Game>::~Uct() {
+  this->StopPonder();
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+const typename Uct<Game>::Board& Uct<Game>::Search(const Board& root) {
+  this->StopPonder();
+
+  const bool has_pondered = this->has_pondered_;
+
+  this->has_pondered_ = false;
+
+  if (this->options_.solve_depth > 0) {
+    const auto index = this->Solve(root);
+
+    if (index != Tree<Board>::kNull) {
+      this->WriteStats();
+
+      return this->workers_[0]->tree->BoardAt(index);
+    }
+  }
+
+  this->Grow(
+    root, this->options_.reuse_tree || has_pondered,
+    this->options_.count_round, this->options_.time_limit,
+    this->options_.count_node_limit);
+
+  if (has_pondered) {
+    // The root was in the pondered tree if some visits carried over.
+    if (this->report_.count_reused_visits > 0) {
+      this->ponder_stats_.count_hit += 1;
+      this->ponder_stats_.count_reused_visits +=
+        this->report_.count_reused_visits;
+    } else {
+      this->ponder_stats_.count_miss += 1;
+    }
+  }
+
+  this->WriteStats();
+
+  return this->workers_[0]->tree->BoardAt(this->BestChild());
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::WriteStats() const {
+  if (this->options_.stats_path.empty()) { return; }
+
+  std::ofstream file(this->options_.stats_path, std::ios::app);
+
+  this->report_.WriteJson(&file);
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::StartPonder(const Board& root) {
+  this->StopPonder();
+
+  // Root may go away (it may even be in the tree) once this returns.
+  this->ponder_arena_.Reset();
+
+  auto clone = Game::Clone(root, &this->ponder_arena_);
+
+  // The tree of the last search usually has root as a child.
+  this->ponder_thread_ = std::thread([this, clone]() {
+    this->Grow(clone, true, 0, 0, this->options_.count_ponder_node_limit);
+  });
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::StopPonder() {
+  if (!this->ponder_thread_.joinable()) { return; }
+
+  this->stop_.store(true, std::memory_order_relaxed);
+  this->ponder_thread_.join();
+  this->stop_.store(false, std::memory_order_relaxed);
+
+  this->has_pondered_ = true;
+  this->ponder_stats_.count_round += this->report_.count_round;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+bool Uct<Game>::IsPondering() const {
+  return this->ponder_thread_.joinable();
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Seed(uint64_t seed) {
+  assert(!this->IsPondering());
+
+  if (seed == 0) { seed = Random::ClockSeed(); }
+
+  for (size_t i = 0; i < this->workers_.size(); ++i) {
+    this->workers_[i]->random.Seed(seed + i);
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Clear() {
+  this->StopPonder();
+
+  // The pondered tree is gone too.
+  this->has_pondered_ = false;
+
+  for (auto& worker : this->workers_) {
+    worker->own_tree->Clear();
+    worker->arena->Reset();
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+const UctPonderStats& Uct<Game>::GetPonderStats() const {
+  return this->ponder_stats_;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Grow(
+    const Board& root, bool reuse, int32_t count_round, int32_t time_limit,
+    uint32_t count_node_limit) {
+  const int32_t count_threads = this->options_.count_threads;
+
+  // Root may be a board in the tree, which is dropped by Reset.
+  Arena arena(kRootArenaSize);
+
+  const auto clone = Game::Clone(root, &arena);
+  const auto start = Clock::now();
+  const auto deadline = time_limit > 0
+    ? start + std::chrono::milliseconds(time_limit)
+    : Clock::time_point::max();
+
+  if (count_round <= 0) {
+    count_round = std::numeric_limits<int32_t>::max();
+  }
+
+  if (count_node_limit == 0) {
+    count_node_limit = std::numeric_limits<uint32_t>::max();
+  }
+
+  // Positions of the last root would never be replaced, most have more
+  // visits than the new ones. The table ages whenever the root moves on,
+  // even if a subtree is kept, the kept nodes have their own statistics.
+  const auto& last = *this->workers_[0]->tree;
+
+  if (this->transpositions_ &&
+      (!reuse || last.CountNodes() == 0 ||
+       !Game::IsSame(last.BoardAt(0), clone))) {
+    this->transpositions_->Age();
+  }
+
+  // Rounds left on the shared tree.
+  std::atomic<int32_t> count_round_left(count_round);
+
+  if (this->is_shared_) {
+    // Boards of the last search are in all arenas, they are dropped after the
+    // subtree which is kept is copied.
+    this->Reset(this->workers_[0].get(), clone, reuse);
+
+    for (auto& worker : this->workers_) {
+      worker->tree = this->workers_[0]->own_tree.get();
+
+      if (worker != this->workers_[0]) {
+        worker->arena->Reset();
+      }
+    }
+  }
+
+  auto fn_search = [&](int32_t index) {
+    auto worker = this->workers_[index].get();
+
+    if (this->is_shared_) {
+      this->Run(worker, count_round, count_node_limit, &count_round_left,
+                deadline);
+    } else {
+      // Split the rounds and nodes as even as possible.
+      auto count_round_thread = count_round / count_threads +
+        (index < count_round % count_threads ? 1 : 0);
+      auto count_node_limit_thread = count_node_limit / count_threads +
+        (static_cast<uint32_t>(index) < count_node_limit % count_threads
+         ? 1 : 0);
+
+      this->Reset(worker, clone, reuse);
+
+      this->Run(worker, count_round_thread, count_node_limit_thread,
+                nullptr, deadline);
+    }
+  };
+
+  std::vector<std::thread> threads;
+
+  for (int32_t i = 1; i < count_threads; ++i) {
+    threads.emplace_back(fn_search, i);
+  }
+
+  fn_search(0);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  this->report_ = UctReport();
+
+  for (const auto& worker : this->workers_) {
+    this->report_.count_round += worker->count_round;
+    this->report_.count_probes += worker->count_probes;
+    this->report_.count_transpositions += worker->count_transpositions;
+    this->report_.count_merged += worker->count_merged;
+    this->report_.stats.Add(worker->stats);
+    this->report_.count_bytes += worker->arena->BytesReserved();
+
+    if (worker->tree == worker->own_tree.get()) {
+      this->report_.count_nodes += worker->tree->CountNodes();
+      this->report_.count_bytes += worker->tree->CountBytes();
+      this->report_.count_reused_visits +=
+        worker->tree->NodeAt(0).count_visits.load();
+    }
+  }
+
+  // Each round visits the root once.
+  this->report_.count_reused_visits -= this->report_.count_round;
+
+  this->report_.is_proven = this->IsProven(*this->workers_[0]->tree, 0);
+
+  this->report_.milliseconds =
+    std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+const typename Uct<Game>::Board& Uct<Game>::SearchDemo(const Board& root) {
+  auto worker = this->workers_[0].get();
+
+  this->StopPonder();
+  this->Reset(worker, root, this->options_.reuse_tree);
+
+  // Other trees stay empty and are ignored by BestChild.
+  for (size_t i = 1; i < this->workers_.size(); ++i) {
+    this->workers_[i]->own_tree->Clear();
+  }
+
+  for (int32_t round = 0; round < this->options_.count_round; ++round) {
+    this->Iterate(worker);
+
+    this->InspectValue(*worker->tree);
+
+    std::cin.get();
+  }
+
+  return worker->tree->BoardAt(this->BestChild());
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+const Tree<typename Uct<Game>::Board>& Uct<Game>::GetTree() const {
+  return *this->workers_[0]->own_tree;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+const UctReport& Uct<Game>::GetReport() const {
+  return this->report_;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+uint32_t Uct<Game>::Solve(const Board& root) {
+  const auto start = Clock::now();
+
+  // Root may be a board in the tree, which is dropped by Reset.
+  Arena arena(kRootArenaSize);
+
+  Board best;
+  int32_t score;
+
+  if (!Game::Solve(root, this->options_.solve_depth, &arena, &best, &score)) {
+    return Tree<Board>::kNull;
+  }
+
+  auto worker = this->workers_[0].get();
+  auto tree = worker->tree;
+
+  this->Reset(worker, Game::Clone(root, &arena), false);
+
+  // Like SearchDemo, the other trees are of no use.
+  for (size_t i = 1; i < this->workers_.size(); ++i) {
+    this->workers_[i]->own_tree->Clear();
+  }
+
+  const auto index = tree->Allocate(1, 0);
+  auto& node = tree->NodeAt(0);
+
+  tree->BoardAt(index) = Game::Clone(best, worker->arena.get());
+
+  if (Game::IsEnd(tree->BoardAt(index))) {
+    tree->NodeAt(index).flags.store(Node::kEnd, std::memory_order_relaxed);
+  }
+
+  if (tree->HasHashes()) {
+    tree->HashAt(index) = Game::Hash(tree->BoardAt(index));
+  }
+
+  node.first_child = index;
+  node.count_children = 1;
+  node.flags.store(Node::kExpanded, std::memory_order_release);
+
+  this->report_ = UctReport();
+  this->report_.count_nodes = tree->CountNodes();
+  this->report_.is_solved = true;
+  this->report_.score = score;
+  this->report_.milliseconds =
+    std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  return index;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Reset(Worker* worker, const Board& root, bool reuse) {
+  if (reuse && worker->tree->CountNodes() > 0) {
+    auto index = this->Find(*worker->tree, root);
+
+    // The same root goes on with the whole tree. The boards of a shared
+    // tree are in the arenas of all workers, which Grow resets, so it is
+    // copied into the arena of the first like any other subtree.
+    if (index == 0 && !this->is_shared_) { return; }
+
+    if (index != Tree<Board>::kNull) {
+      this->Rebase(worker, index);
+
+      return;
+    }
+  }
+
+  auto tree = worker->tree;
+
+  // The whole last tree lives in the arenas and is dropped with them at once.
+  tree->Clear();
+  worker->arena->Reset();
+
+  // I don't want to manipulate root.
+  auto index = tree->Allocate(1, Tree<Board>::kNull);
+
+  tree->BoardAt(index) = Game::Clone(root, worker->arena.get());
+
+  if (Game::IsEnd(tree->BoardAt(index))) {
+    tree->NodeAt(index).flags.store(Node::kEnd, std::memory_order_relaxed);
+  }
+
+  if (this->transpositions_) {
+    tree->HashAt(index) = Game::Hash(tree->BoardAt(index));
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+uint32_t Uct<Game>::Find(const Tree<Board>& tree, const Board& root) const {
+  if (Game::IsSame(tree.BoardAt(0), root)) { return 0; }
+
+  const auto& node = tree.NodeAt(0);
+
+  for (uint32_t i = 0; i < node.count_children; ++i) {
+    const auto index = node.first_child + i;
+    const auto& child = tree.NodeAt(index);
+
+    if (Game::IsSame(tree.BoardAt(index), root)) { return index; }
+
+    for (uint32_t j = 0; j < child.count_children; ++j) {
+      if (Game::IsSame(tree.BoardAt(child.first_child + j), root)) {
+        return child.first_child + j;
+      }
+    }
+  }
+
+  return Tree<Board>::kNull;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Rebase(Worker* worker, uint32_t index) {
+  const auto& source = *worker->tree;
+  auto target = worker->spare_tree.get();
+  auto arena = worker->spare_arena.get();
+
+  target->Clear();
+  arena->Reset();
+
+  // Pairs of source / target indices, breadth first so the children of each
+  // node stay contiguous in target.
+  std::vector<std::pair<uint32_t, uint32_t>> pending;
+
+  pending.emplace_back(index, target->Allocate(1, Tree<Board>::kNull));
+
+  for (size_t i = 0; i < pending.size(); ++i) {
+    const auto& from = source.NodeAt(pending[i].first);
+    auto& to = target->NodeAt(pending[i].second);
+
+    target->BoardAt(pending[i].second) =
+      Game::Clone(source.BoardAt(pending[i].first), arena);
+
+    // No expansion is running between searches.
+    to.flags.store(
+      from.flags.load() & (Node::kEnd | Node::kExpanded | Node::kProven),
+      std::memory_order_relaxed);
+    to.count_visits.store(from.count_visits.load(), std::memory_order_relaxed);
+    to.count_wins.store(from.count_wins.load(), std::memory_order_relaxed);
+
+    if (source.HasHashes()) {
+      target->HashAt(pending[i].second) = source.HashAt(pending[i].first);
+    }
+
+    if (from.count_children == 0) { continue; }
+
+    to.count_children = from.count_children;
+    to.first_child = target->Allocate(from.count_children, pending[i].second);
+
+    for (uint32_t c = 0; c < from.count_children; ++c) {
+      pending.emplace_back(from.first_child + c, to.first_child + c);
+    }
+  }
+
+  // Drop the last tree with the boards of worker.
+  std::swap(worker->own_tree, worker->spare_tree);
+  std::swap(worker->arena, worker->spare_arena);
+
+  worker->tree = worker->own_tree.get();
+  worker->spare_tree->Clear();
+  worker->spare_arena->Reset();
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::Run(
+    Worker* worker, int32_t count_round, uint32_t count_node_limit,
+    std::atomic<int32_t>* count_round_left,
+    const Clock::time_point& deadline) {
+  worker->count_round = 0;
+  worker->stats = UctStats();
+  worker->count_probes = 0;
+  worker->count_transpositions = 0;
+  worker->count_merged = 0;
+
+  for (int32_t round = 0; ; ++round) {
+    if (count_round_left != nullptr) {
+      if (count_round_left->fetch_sub(1, std::memory_order_relaxed) <= 0) {
+        break;
+      }
+    } else if (round >= count_round) {
+      break;
+    }
+
+    // The first round always runs so the root has children to choose from.
+    if (round > 0) {
+      if (worker->tree->CountNodes() >= count_node_limit) { break; }
+
+      if (this->stop_.load(std::memory_order_relaxed)) { break; }
+
+      if (this->options_.prove && this->IsProven(*worker->tree, 0)) { break; }
+
+      if (round % kClockInterval == 0 && Clock::now() >= deadline) { break; }
+    }
+
+    this->Iterate(worker);
+
+    worker->count_round += 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline void Uct<Game>::Iterate(Worker* worker) {
+  auto tree = worker->tree;
+
+  UCT_STAT(auto& stats = worker->stats);
+  UCT_STAT(auto time = Clock::now());
+
+  auto selected = this->Select(worker);
+
+  UCT_STAT(stats.nanoseconds_select += Uct::Lap(&time));
+
+  // On a shared tree, a leaf being expanded by another thread is simulated
+  // as it is, so is a node with all children proven (proven by Select).
+  if (!this->IsEnd(*tree, selected) && !this->IsExpanded(*tree, selected) &&
+      this->LockExpansion(tree, selected)) {
+    selected = this->Expand(worker, selected);
+  }
+
+  UCT_STAT(stats.nanoseconds_expand += Uct::Lap(&time));
+  UCT_STAT(const auto count_draws = worker->random.CountDraws());
+
+  auto winner = Game::Simulate(tree->BoardAt(selected), &worker->random);
+
+  UCT_STAT(stats.nanoseconds_simulate += Uct::Lap(&time));
+  UCT_STAT(stats.count_playout_plies +=
+           worker->random.CountDraws() - count_draws);
+
+  this->Backpropagate(tree, selected, winner);
+
+  UCT_STAT(stats.nanoseconds_backpropagate += Uct::Lap(&time));
+  UCT_STAT(stats.count_iterations += 1);
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline uint64_t Uct<Game>::Lap(Clock::time_point* time) {
+  const auto now = Clock::now();
+  const auto nanoseconds =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(now - *time);
+
+  *time = now;
+
+  return static_cast<uint64_t>(nanoseconds.count());
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline bool Uct<Game>::IsEnd(const Tree<Board>& tree, uint32_t index) const {
+  // Set before the node is published, never changes later.
+  auto flags = tree.NodeAt(index).flags.load(std::memory_order_relaxed);
+
+  return (flags & Node::kEnd) != 0;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline bool Uct<Game>::IsExpanded(
+    const Tree<Board>& tree, uint32_t index) const {
+  // Pairs with the release in Expand, the children are ready once seen.
+  auto flags = tree.NodeAt(index).flags.load(std::memory_order_acquire);
+
+  return (flags & Node::kExpanded) != 0;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline bool Uct<Game>::IsProven(
+    const Tree<Board>& tree, uint32_t index) const {
+  auto flags = tree.NodeAt(index).flags.load(std::memory_order_relaxed);
+
+  return (flags & Node::kProven) != 0;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline uint32_t Uct<Game>::Select(Worker* worker) {
+  auto tree = worker->tree;
+  auto transpositions = this->transpositions_.get();
+
+  uint32_t index = 0;
+
+  UCT_STAT(uint32_t depth = 0);
+
+  if (this->is_shared_) {
+    this->AddVirtualLoss(tree, index);
+  }
+
+  // If there are no more moves, stop here.
+  // If there are no children, stop here to expand.
+  while (this->IsExpanded(*tree, index) && !this->IsEnd(*tree, index)) {
+    const auto& node = tree->NodeAt(index);
+    const auto double_log = Ucb::DoubleLog(
+      node.count_visits.load(std::memory_order_relaxed));
+
+    auto selected = Tree<Board>::kNull;
+    auto selected_value = -1.0f;
+
+    // The first child with the highest value.
+    for (uint32_t i = 0; i < node.count_children; ++i) {
+      const auto& child = tree->NodeAt(node.first_child + i);
+
+      // Nothing more to learn below. A proven win of the player to move has
+      // proven node already, in Expand or in Backpropagate.
+      if (this->options_.prove && this->IsProven(*tree, node.first_child + i)) {
+        continue;
+      }
+
+      auto count_visits = child.count_visits.load(std::memory_order_relaxed);
+      auto count_wins = child.count_wins.load(std::memory_order_relaxed);
+
+      // The position may have been searched more along other move orders.
+      const auto hash = transpositions != nullptr
+        ? tree->HashAt(node.first_child + i) : 0;
+
+      if (hash != 0) {
+        auto entry = transpositions->Find(hash);
+
+        worker->count_probes += 1;
+
+        if (entry != nullptr &&
+            entry->count_visits.load(std::memory_order_relaxed) >
+            count_visits) {
+          count_visits = entry->count_visits.load(std::memory_order_relaxed);
+          count_wins = entry->count_wins.load(std::memory_order_relaxed);
+
+          worker->count_transpositions += 1;
+        }
+      }
+
+      if (count_visits == 0) {
+        selected = node.first_child + i;
+        break;
+      }
+
+      auto value = Ucb::Value(double_log, count_visits, count_wins);
+
+      if (selected_value < value) {
+        selected = node.first_child + i;
+        selected_value = value;
+      }
+    }
+
+    // All children are proven. Threads proving the last two children at once
+    // may each miss the proof of the other and leave node unproven, prove it
+    // here, Backpropagate goes on proving from it.
+    if (selected == Tree<Board>::kNull) {
+      this->Prove(tree, index);
+
+      break;
+    }
+
+    index = selected;
+
+    UCT_STAT(depth += 1);
+
+    if (this->is_shared_) {
+      this->AddVirtualLoss(tree, index);
+    }
+  }
+
+  UCT_STAT(worker->stats.sum_select_depths += depth);
+  UCT_STAT(worker->stats.max_select_depth =
+           std::max(worker->stats.max_select_depth, depth));
+
+  return index;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline bool Uct<Game>::LockExpansion(Tree<Board>* tree, uint32_t index) {
+  auto& flags = tree->NodeAt(index).flags;
+  auto expected = flags.load(std::memory_order_relaxed);
+
+  if (!this->is_shared_) {
+    flags.store(expected | Node::kExpanding, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  do {
+    if ((expected & (Node::kExpanding | Node::kExpanded)) != 0) {
+      return false;
+    }
+  } while (!flags.compare_exchange_weak(
+      expected, expected | Node::kExpanding, std::memory_order_relaxed));
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline uint32_t Uct<Game>::Expand(Worker* worker, uint32_t index) {
+  auto tree = worker->tree;
+
+  Board children[Game::kMaxChildren];
+
+  uint64_t hashes[Game::kMaxChildren];
+
+  auto count =
+    Game::Expand(tree->BoardAt(index), worker->arena.get(), children);
+
+  if (this->transpositions_ || this->options_.merge_symmetries) {
+    for (auto i = 0; i < count; ++i) {
+      hashes[i] = Game::Hash(children[i]);
+    }
+  }
+
+  if (this->options_.merge_symmetries) {
+    auto count_kept = 0;
+
+    // The first child of each hash stays.
+    for (auto i = 0; i < count; ++i) {
+      auto is_merged = false;
+
+      for (auto j = 0; j < count_kept && hashes[i] != 0; ++j) {
+        is_merged = is_merged || hashes[j] == hashes[i];
+      }
+
+      if (is_merged) { continue; }
+
+      children[count_kept] = children[i];
+      hashes[count_kept] = hashes[i];
+      count_kept += 1;
+    }
+
+    worker->count_merged += count - count_kept;
+
+    count = count_kept;
+  }
+
+  auto first = tree->Allocate(count, index);
+
+  UCT_STAT(worker->stats.count_nodes_allocated += count);
+
+  for (auto i = 0; i < count; ++i) {
+    tree->BoardAt(first + i) = children[i];
+
+    if (Game::IsEnd(children[i])) {
+      const auto proof =
+        this->options_.prove ? this->ProofOf(children[i]) : 0;
+
+      tree->NodeAt(first + i).flags.store(
+        Node::kEnd | proof, std::memory_order_relaxed);
+    }
+
+    if (this->transpositions_) {
+      tree->HashAt(first + i) = hashes[i];
+    }
+  }
+
+  auto& node = tree->NodeAt(index);
+
+  node.first_child = first;
+  node.count_children = count;
+
+  // An end among the children may prove node, whichever child it is.
+  if (this->options_.prove) {
+    this->Prove(tree, index);
+  }
+
+  node.flags.fetch_or(Node::kExpanded, std::memory_order_release);
+
+  if (this->is_shared_) {
+    this->AddVirtualLoss(tree, first);
+  }
+
+  return first;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline void Uct<Game>::AddVirtualLoss(Tree<Board>* tree, uint32_t index) {
+  // Visits without wins, taken back in Backpropagate but for the real one.
+  tree->NodeAt(index).count_visits.fetch_add(
+    this->options_.virtual_loss, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline void Uct<Game>::Backpropagate(
+    Tree<Board>* tree, uint32_t index, int32_t winner) {
+  const uint32_t undo = this->options_.virtual_loss - 1;
+
+  // Proofs go up as long as the parents are proven by them, from index or
+  // from its parent, which Expand proves from all of its children.
+  const auto parent = tree->NodeAt(index).parent;
+
+  auto is_proving = this->options_.prove &&
+    (this->IsProven(*tree, index) ||
+     (parent != Tree<Board>::kNull && this->IsProven(*tree, parent)));
+
+  while (true) {
+    auto& node = tree->NodeAt(index);
+    auto reward = Game::Reward(tree->BoardAt(index), winner);
+
+    if (this->is_shared_) {
+      auto count_wins = node.count_wins.load(std::memory_order_relaxed);
+
+      while (!node.count_wins.compare_exchange_weak(
+          count_wins, count_wins + reward, std::memory_order_relaxed)) {
+      }
+
+      if (undo != 0) {
+        node.count_visits.fetch_sub(undo, std::memory_order_relaxed);
+      }
+    } else {
+      // Only this thread touches the tree, skip the locked instructions.
+      node.count_visits.store(
+        node.count_visits.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+      node.count_wins.store(
+        node.count_wins.load(std::memory_order_relaxed) + reward,
+        std::memory_order_relaxed);
+    }
+
+    if (this->transpositions_ && tree->HashAt(index) != 0) {
+      this->AddToTable(tree->HashAt(index), reward);
+    }
+
+    if (node.parent == Tree<Board>::kNull) { break; }
+
+    index = node.parent;
+
+    if (is_proving) {
+      is_proving = this->Prove(tree, index);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline uint16_t Uct<Game>::ProofOf(const Board& board) const {
+  // Not the reward, which may not tell a draw from a win.
+  const auto outcome = Game::Outcome(board);
+
+  if (outcome > 0) { return Node::kProvenWin; }
+  if (outcome < 0) { return Node::kProvenLoss; }
+
+  return Node::kProvenDraw;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline bool Uct<Game>::Prove(Tree<Board>* tree, uint32_t index) {
+  auto& node = tree->NodeAt(index);
+
+  if (this->IsProven(*tree, index)) { return true; }
+
+  auto is_all_proven = true;
+  auto has_draw = false;
+
+  // The children were moved into by the player to move at node.
+  for (uint32_t i = 0; i < node.count_children; ++i) {
+    const auto flags = tree->NodeAt(node.first_child + i).flags.load(
+      std::memory_order_relaxed);
+
+    if ((flags & Node::kProvenWin) != 0) {
+      node.flags.fetch_or(Node::kProvenLoss, std::memory_order_relaxed);
+
+      return true;
+    }
+
+    is_all_proven = is_all_proven && (flags & Node::kProven) != 0;
+    has_draw = has_draw || (flags & Node::kProvenDraw) != 0;
+  }
+
+  if (!is_all_proven) { return false; }
+
+  node.flags.fetch_or(
+    has_draw ? Node::kProvenDraw : Node::kProvenWin,
+    std::memory_order_relaxed);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+inline void Uct<Game>::AddToTable(uint64_t hash, float reward) {
+  auto entry = this->transpositions_->Insert(hash);
+
+  if (this->options_.count_threads == 1) {
+    entry->count_visits.store(
+      entry->count_visits.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+    entry->count_wins.store(
+      entry->count_wins.load(std::memory_order_relaxed) + reward,
+      std::memory_order_relaxed);
+
+    return;
+  }
+
+  // The table is shared by all threads, even with a tree per thread.
+  auto count_wins = entry->count_wins.load(std::memory_order_relaxed);
+
+  entry->count_visits.fetch_add(1, std::memory_order_relaxed);
+
+  while (!entry->count_wins.compare_exchange_weak(
+      count_wins, count_wins + reward, std::memory_order_relaxed)) {
+  }
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+uint32_t Uct<Game>::BestChild() const {
+  const auto& tree = *this->workers_[0]->tree;
+  const auto& root = tree.NodeAt(0);
+
+  assert(root.count_children > 0);
+
+  // Every tree expands the root into the same children in the same order.
+  uint64_t count_visits[Game::kMaxChildren] = {0};
+  uint16_t flags[Game::kMaxChildren] = {0};
+
+  // A shared tree is counted once, from the first worker.
+  for (const auto& worker : this->workers_) {
+    const auto& other = *worker->own_tree;
+
+    if (worker->tree != &other || other.CountNodes() == 0) { continue; }
+
+    const auto& other_root = other.NodeAt(0);
+
+    for (uint32_t i = 0; i < other_root.count_children; ++i) {
+      const auto& child = other.NodeAt(other_root.first_child + i);
+
+      count_visits[i] += child.count_visits.load();
+      flags[i] |= child.flags.load();
+    }
+  }
+
+  // 2 for a proven win, 0 for a proven loss, 1 for the others. A proven draw
+  // is not preferred to a move which may win, nor the other way round.
+  auto rank = [&](uint32_t i) {
+    if (!this->options_.prove) { return 1; }
+    if ((flags[i] & Node::kProvenWin) != 0) { return 2; }
+    if ((flags[i] & Node::kProvenLoss) != 0) { return 0; }
+
+    return 1;
+  };
+
+  uint32_t best = 0;
+
+  for (uint32_t i = 1; i < root.count_children; ++i) {
+    if (rank(best) < rank(i) ||
+        (rank(best) == rank(i) && count_visits[best] < count_visits[i])) {
+      best = i;
+    }
+  }
+
+  return root.first_child + best;
+}
+
+//------------------------------------------------------------------------------
+template <class Game>
+void Uct<Game>::InspectValue(const Tree<Board>& tree) const {
+  const auto& root = tree.NodeAt(0);
+  const auto double_log = Ucb::DoubleLog(root.count_visits.load());
+
+  Game::Inspect(tree.BoardAt(0));
+
+  auto visited_max = root.first_child;
+  auto value_max = root.first_child;
+
+  float values[Game::kMaxChildren];
+
+  for (uint32_t i = 0; i < root.count_children; ++i) {
+    const auto& child = tree.NodeAt(root.first_child + i);
+
+    values[i] = Ucb::Value(
+      double_log, child.count_visits.load(), child.count_wins.load());
+
+    if (tree.NodeAt(visited_max).count_visits.load() <
+        child.count_visits.load()) {
+      visited_max = root.first_child + i;
+    }
+
+    if (values[value_max - root.first_child] < values[i]) {
+      value_max = root.first_child + i;
+    }
+  }
+
+  for (uint32_t i = 0; i < root.count_children; ++i) {
+    const auto& child = tree.NodeAt(root.first_child + i);
+
+    std::cout << std::endl;
+
+    if (root.first_child + i == visited_max) {
+      std::cout << "\033[1;31m";
+    } else if (root.first_child + i == value_max) {
+      std::cout << "\033[1;36m";
+    } else {
+      std::cout << "\033[37m";
+    }
+
+    std::cout << "visits: " << child.count_visits.load() << std::endl;
+    std::cout << "value:  " << values[i] << std::endl;
+
+    std::cout << "\033[0m";
+  }
+}
+
+#endif  // REVERSI_UCT_INL_H__
@@ -1,71 +1,85 @@
 // Copyright 2016 iRonhead
 #include <cassert>
-#include <cstdlib>
-#include <ctime>
-#include <iostream>
-#include <memory>
 #include "uct.hpp"
 
-using std::cin;
-using std::shared_ptr;
-using std::srand;
-using std::time;
+using std::endl;
+using std::ostream;
 
 //------------------------------------------------------------------------------
-UpperConfidenceTree::UpperConfidenceTree(int32_t count_round)
-    : count_round_(count_round) {
-  // Simulatation needs random numbers.
-  srand(time(nullptr));
+void UctReport::WriteJson(ostream* stream) const {
+  const auto& stats = this->stats;
+
+  *stream
+    << "{\"count_round\": " << this->count_round
+    << ", \"count_nodes\": " << this->count_nodes
+    << ", \"count_bytes\": " << this->count_bytes
+    << ", \"count_reused_visits\": " << this->count_reused_visits
+    << ", \"count_probes\": " << this->count_probes
+    << ", \"count_transpositions\": " << this->count_transpositions
+    << ", \"count_merged\": " << this->count_merged
+    << ", \"is_solved\": " << (this->is_solved ? "true" : "false")
+    << ", \"score\": " << this->score
+    << ", \"is_proven\": " << (this->is_proven ? "true" : "false")
+    << ", \"milliseconds\": " << this->milliseconds
+    << ", \"stats\": {\"count_iterations\": " << stats.count_iterations
+    << ", \"average_select_depth\": " << stats.AverageSelectDepth()
+    << ", \"max_select_depth\": " << stats.max_select_depth
+    << ", \"count_nodes_allocated\": " << stats.count_nodes_allocated
+    << ", \"count_playout_plies\": " << stats.count_playout_plies
+    << ", \"nanoseconds_select\": " << stats.nanoseconds_select
+    << ", \"nanoseconds_expand\": " << stats.nanoseconds_expand
+    << ", \"nanoseconds_simulate\": " << stats.nanoseconds_simulate
+    << ", \"nanoseconds_backpropagate\": " << stats.nanoseconds_backpropagate
+    << "}}" << endl;
 }
 
 //------------------------------------------------------------------------------
-State* UpperConfidenceTree::Search(State* root) const {
-  assert(root != nullptr);
-
-  // I don't want to manipulate root.
-  shared_ptr<State> temp(root->Clone());
-
-  State* selected = nullptr;
-
-  for (int32_t round = 0; round < this->count_round_; ++round) {
-    selected = temp->Select();
-
-    if (selected->IsNormal()) {
-      selected = selected->Expand();
-    }
+UpperConfidenceTree::UpperConfidenceTree(int32_t count_round, bool huge_pages)
+    : uct_(count_round, huge_pages) {
+}
 
-    auto winner = selected->Simulate();
+//------------------------------------------------------------------------------
+UpperConfidenceTree::UpperConfidenceTree(const UctOptions& options)
+    : uct_(options) {
+}
 
-    selected->Backpropagate(winner);
-  }
+//------------------------------------------------------------------------------
+State* UpperConfidenceTree::Search(State* root) const {
+  assert(root != nullptr);
 
-  return temp->BestMove();
+  return this->uct_.Search(root)->Clone();
 }
 
 //------------------------------------------------------------------------------
 State* UpperConfidenceTree::SearchDemo(State* root) const {
   assert(root != nullptr);
 
-  // I don't want to manipulate root.
-  shared_ptr<State> temp(root->Clone());
-
-  State* selected = nullptr;
-
-  for (int32_t round = 0; round < this->count_round_; ++round) {
-    selected = temp->Select();
+  return this->uct_.SearchDemo(root)->Clone();
+}
 
-    if (selected->IsNormal()) {
-      selected = selected->Expand();
-    }
+//------------------------------------------------------------------------------
+void UpperConfidenceTree::StartPonder(State* root) const {
+  assert(root != nullptr);
 
-    auto winner = selected->Simulate();
+  this->uct_.StartPonder(root);
+}
 
-    selected->Backpropagate(winner);
+//------------------------------------------------------------------------------
+void UpperConfidenceTree::StopPonder() const {
+  this->uct_.StopPonder();
+}
 
-    temp->InspectValue();
+//------------------------------------------------------------------------------
+void UpperConfidenceTree::Seed(uint64_t seed) const {
+  this->uct_.Seed(seed);
+}
 
-    cin.get();
-  }
+//------------------------------------------------------------------------------
+const UctPonderStats& UpperConfidenceTree::GetPonderStats() const {
+  return this->uct_.GetPonderStats();
+}
 
-  return temp->BestMove();
+//------------------------------------------------------------------------------
+const UctReport& UpperConfidenceTree::GetReport() const {
+  return this->uct_.GetReport();
 }
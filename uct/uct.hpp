@@ -2,18 +2,401 @@
 #ifndef REVERSI_UCT_H__
 #define REVERSI_UCT_H__
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arena.hpp"
+#include "random.hpp"
 #include "state.hpp"
+#include "stats.hpp"
+#include "transposition.hpp"
+#include "tree.hpp"
 
+struct UctOptions {
+  enum Parallelism {
+    // Each thread grows its own tree from the root, the visits of the root
+    // children are summed to pick the best move.
+    kRoot,
+
+    // All threads grow one shared tree. Selection adds virtual losses so
+    // concurrent threads spread over different paths.
+    kTree,
+  };
+
+  // Rounds of select / expand / simulate / backpropagate per search, shared
+  // by all threads. 0 for no limit.
+  int32_t     count_round;
+
+  // Wall-clock milliseconds per search, 0 for no limit.
+  int32_t     time_limit;
+
+  // Nodes per search, in all trees, 0 for no limit. A search may go over by
+  // the children of one expansion per thread.
+  uint32_t    count_node_limit;
+
+  int32_t     count_threads;
+  Parallelism parallelism;
+
+  // Visits added to each node on the selected path of a shared tree until
+  // the playout is backpropagated.
+  int32_t     virtual_loss;
+
+  // Back the trees with huge pages when the system supports them.
+  bool        huge_pages;
+
+  // Keep the tree between searches. When the next root is the last root, one
+  // of its children or one of its grandchildren (the move of the engine and
+  // the reply), the subtree below it is carried over with its statistics.
+  bool        reuse_tree;
+
+  // Nodes per ponder, 0 for no limit. Pondering has no other limit.
+  uint32_t    count_ponder_node_limit;
+
+  // Bytes of the transposition table, 0 for none. With a table, the value
+  // of a child is computed from the statistics of its position over all
+  // move orders in the tree. It is aged with the tree unless the tree is
+  // reused. Game::Hash must not be 0 for the table to be used.
+  size_t      transposition_table_size;
+
+  // Keep one of the children with the same Game::Hash, for a game which
+  // hashes symmetric positions alike (e.g. ReversiGame) symmetric moves are
+  // searched as one.
+  bool        merge_symmetries;
+
+  // Solve roots with at most this many moves left (empty squares of
+  // reversi) exactly with Game::Solve instead of searching, 0 for never.
+  int32_t     solve_depth;
+
+  // Prove the results of ends (Game::Outcome) and, minimax-style, of the
+  // nodes with a child won by the player to move or with all children
+  // proven. Select skips proven children and a search stops once its root is
+  // proven. The players must take turns along the tree, a pass being a move.
+  bool        prove;
+
+  // Seed of the random numbers of the playouts, 0 for one from the clock.
+  // The threads draw from generators of their own, seeded with seed plus
+  // their index, a search on one thread with a seed is repeated exactly.
+  uint64_t    seed;
+
+  // Append the report of each search to this file as a line of JSON, see
+  // UctReport::WriteJson, nothing if it is empty.
+  std::string stats_path;
+
+  UctOptions() : count_round(10000), time_limit(0), count_node_limit(0),
+      count_threads(1), parallelism(kRoot), virtual_loss(1),
+      huge_pages(false), reuse_tree(false),
+      count_ponder_node_limit(1u << 22), transposition_table_size(0),
+      merge_symmetries(false), solve_depth(0), prove(false),
+      seed(0) {}
+};
+
+// What the last search did.
+struct UctReport {
+  // Rounds completed by all threads.
+  int32_t   count_round;
+
+  // Nodes in all trees, and the bytes held by the trees and the arenas of
+  // Game::Clone.
+  uint32_t  count_nodes;
+  size_t    count_bytes;
+
+  // Visits of the root carried over from the last search, see
+  // UctOptions::reuse_tree. The root has count_round more visits.
+  uint32_t  count_reused_visits;
+
+  // Children looked up in the transposition table, and those the table had
+  // more visits of (reached by other move orders) than the child itself.
+  uint64_t  count_probes;
+  uint64_t  count_transpositions;
+
+  // Children dropped by UctOptions::merge_symmetries.
+  uint64_t  count_merged;
+
+  // True if the root was solved instead of searched, see
+  // UctOptions::solve_depth. score is then the exact score of the player to
+  // move at the root.
+  bool      is_solved;
+  int32_t   score;
+
+  // True if the root was proven, see UctOptions::prove.
+  bool      is_proven;
+
+  // Wall-clock time of the search.
+  double    milliseconds;
+
+  // Collected by UCT_STATS builds only.
+  UctStats  stats;
+
+  UctReport() : count_round(0), count_nodes(0), count_bytes(0),
+      count_reused_visits(0),
+      count_probes(0), count_transpositions(0), count_merged(0),
+      is_solved(false), score(0), is_proven(false), milliseconds(0.0) {}
+
+  // The report and its stats as one line of JSON.
+  void WriteJson(std::ostream* stream) const;
+};
+
+// What pondering earned, over the life of a search.
+struct UctPonderStats {
+  // Searches after a ponder which found their root in the pondered tree, and
+  // which did not.
+  int32_t   count_hit;
+  int32_t   count_miss;
+
+  // Rounds done while pondering.
+  int64_t   count_round;
+
+  // Root visits carried over by the hits.
+  int64_t   count_reused_visits;
+
+  UctPonderStats() : count_hit(0), count_miss(0), count_round(0),
+      count_reused_visits(0) {}
+};
+
+// Upper confidence tree search over a game known at compile time, so select,
+// expand, simulate and backpropagate all inline. Game is a traits class:
+//
+// class Game {
+//  public:
+//   typedef ... Board;
+//
+//   // Upper bound of the number of children of a board.
+//   static const int32_t kMaxChildren;
+//
+//   // Copy of board which stays valid as long as arena.
+//   static Board Clone(const Board& board, Arena* arena);
+//
+//   static bool IsEnd(const Board& board);
+//
+//   // True if a and b are the same position.
+//   static bool IsSame(const Board& a, const Board& b);
+//
+//   // Hash of the position, 0 if it is not hashed. Positions with the same
+//   // hash share statistics.
+//   static uint64_t Hash(const Board& board);
+//
+//   // Put the boards one move away into children and return how many there
+//   // are. A board which is not an end has at least one child (a pass).
+//   static int32_t Expand(const Board& board, Arena* arena, Board* children);
+//
+//   // Play to the end and return the winner.
+//   static int32_t Simulate(const Board& board, Random* random);
+//
+//   // How much the player who moved into board earns when winner wins.
+//   static float Reward(const Board& board, int32_t winner);
+//
+//   // Result of an end for the player who moved into board: 1 for a win, -1
+//   // for a loss and 0 for a draw. Proofs are made of it, see
+//   // UctOptions::prove.
+//   static int32_t Outcome(const Board& board);
+//
+//   // If board has at most depth moves left, put its best child (a clone in
+//   // arena) into best, the exact score of the player to move into score and
+//   // return true. Return false for a board which is not solved, e.g. an
+//   // end or a game without a solver.
+//   static bool Solve(const Board& board, int32_t depth, Arena* arena,
+//                     Board* best, int32_t* score);
+//
+//   static void Inspect(const Board& board);
+// };
+//
+// With a shared tree, boards are only read by other threads once published
+// and the functions above must be safe to call on the same board at once.
+//
+// See StateGame and ReversiGame.
+template <class Game>
+class Uct {
+ public:
+  typedef typename Game::Board Board;
+
+ public:
+  explicit Uct(const UctOptions& options);
+  explicit Uct(int32_t count_round, bool huge_pages = false);
+
+  ~Uct();
+
+  Uct(const Uct&) = delete;
+  Uct& operator=(const Uct&) = delete;
+
+  // Search from root until a limit of the options is hit and return the
+  // board of the most visited move. The returned board lives in the tree, it
+  // is valid until the next search. At least one round is done per thread.
+  const Board& Search(const Board& root);
+
+  // Search step by step on one thread, inspect the root after each round.
+  const Board& SearchDemo(const Board& root);
+
+  // Keep searching from root on a background thread until StopPonder or
+  // the next search, which carries over the subtree of the position it is
+  // asked about. Root is usually the board returned by the last search,
+  // pondering the reply of the opponent. The tree and the report must not
+  // be read while pondering.
+  void StartPonder(const Board& root);
+
+  // Does nothing if not pondering.
+  void StopPonder();
+
+  bool IsPondering() const;
+
+  // Restart the random numbers of the threads from seed as UctOptions::seed
+  // does, 0 for one from the clock.
+  void Seed(uint64_t seed);
+
+  // Drop the trees and release their memory but the first blocks, the next
+  // search starts afresh even with UctOptions::reuse_tree. Stops pondering.
+  void Clear();
+
+  const UctPonderStats& GetPonderStats() const;
+
+  // The tree of the first thread.
+  const Tree<Board>& GetTree() const;
+
+  const UctReport& GetReport() const;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  // Clock::now() is checked once per this many rounds of a thread.
+  static const int32_t kClockInterval = 64;
+
+  // Blocks of the arenas keeping a copy of a root.
+  static const size_t kRootArenaSize = 4096;
+
+  // What one thread works with. arena keeps the allocations of Game, tree
+  // is own_tree or the own_tree of the first worker when it is shared. A
+  // carried over subtree is copied into the spares, which are then swapped
+  // in.
+  struct Worker {
+    Worker(const UctOptions& options, uint64_t seed);
+
+    std::unique_ptr<Arena>        arena;
+    std::unique_ptr<Arena>        spare_arena;
+    std::unique_ptr<Tree<Board>>  own_tree;
+    std::unique_ptr<Tree<Board>>  spare_tree;
+    Tree<Board>*                  tree;
+    Random                        random;
+
+    // Rounds completed in the last search.
+    int32_t                       count_round;
+
+    // Transposition table counters of the last search, see UctReport.
+    uint64_t                      count_probes;
+    uint64_t                      count_transpositions;
+    uint64_t                      count_merged;
+
+    // Of the last search, see UctStats.
+    UctStats                      stats;
+  };
+
+  // Search from root with all threads until a limit (0 for none) is hit or
+  // stop_ is set, then fill report_.
+  void Grow(const Board& root, bool reuse, int32_t count_round,
+            int32_t time_limit, uint32_t count_node_limit);
+
+  // Solve root if it is within UctOptions::solve_depth, keep it as the only
+  // node of the tree of the first worker and its best move as the only child
+  // and fill report_. Return the index of the child, kNull if root is not
+  // solved.
+  uint32_t Solve(const Board& root);
+
+  // Plant root, with reuse on the subtree of the last search if it is there.
+  void Reset(Worker* worker, const Board& root, bool reuse);
+
+  // Index of root in the top 3 levels of tree, kNull if it is not there.
+  uint32_t Find(const Tree<Board>& tree, const Board& root) const;
+
+  // Make the subtree below index the whole tree of worker.
+  void Rebase(Worker* worker, uint32_t index);
+
+  // Search on one thread until a limit is hit or stop_ is set.
+  void Run(Worker* worker, int32_t count_round, uint32_t count_node_limit,
+           std::atomic<int32_t>* count_round_left,
+           const Clock::time_point& deadline);
+
+  // One round of select / expand / simulate / backpropagate.
+  void Iterate(Worker* worker);
+
+  // Append report_ to UctOptions::stats_path if there is one.
+  void WriteStats() const;
+
+  // Nanoseconds from time to now, time is then now.
+  static uint64_t Lap(Clock::time_point* time);
+
+  bool IsEnd(const Tree<Board>& tree, uint32_t index) const;
+  bool IsExpanded(const Tree<Board>& tree, uint32_t index) const;
+  bool IsProven(const Tree<Board>& tree, uint32_t index) const;
+
+  // Descend from the root along the highest values to a leaf.
+  uint32_t Select(Worker* worker);
+
+  // Only one thread expands a node, return false if another one does.
+  bool LockExpansion(Tree<Board>* tree, uint32_t index);
+
+  // Add the children of a leaf and return the first one.
+  uint32_t Expand(Worker* worker, uint32_t index);
+
+  void AddVirtualLoss(Tree<Board>* tree, uint32_t index);
+
+  void Backpropagate(Tree<Board>* tree, uint32_t index, int32_t winner);
+
+  // The proof of an end, one of Node::kProven.
+  uint16_t ProofOf(const Board& board) const;
+
+  // Prove an expanded node from its children, return true if it is proven.
+  bool Prove(Tree<Board>* tree, uint32_t index);
+
+  // Add a playout to the statistics of a position in the table.
+  void AddToTable(uint64_t hash, float reward);
+
+  // The most visited child of the root, with the visits of all trees. With
+  // UctOptions::prove, a proven win comes first and proven losses last.
+  uint32_t BestChild() const;
+
+  void InspectValue(const Tree<Board>& tree) const;
+
+  UctOptions                            options_;
+  UctReport                             report_;
+  std::unique_ptr<TranspositionTable>   transpositions_;
+  UctPonderStats                        ponder_stats_;
+  bool                                  is_shared_;
+  bool                                  has_pondered_;
+  std::atomic<bool>                     stop_;
+  std::thread                           ponder_thread_;
+  Arena                                 ponder_arena_;
+  std::vector<std::unique_ptr<Worker>>  workers_;
+};
+
+// The search over State, for callers which hold polymorphic states.
 class UpperConfidenceTree {
  public:
-  explicit UpperConfidenceTree(int32_t count_round);
+  // With huge_pages, the tree of each search is backed by huge pages when the
+  // system supports them.
+  explicit UpperConfidenceTree(int32_t count_round, bool huge_pages = false);
+  explicit UpperConfidenceTree(const UctOptions& options);
 
+  // Return a heap clone of the best move from root.
   State* Search(State* root) const;
   State* SearchDemo(State* root) const;
 
+  void StartPonder(State* root) const;
+  void StopPonder() const;
+
+  // See Uct::Seed.
+  void Seed(uint64_t seed) const;
+
+  const UctPonderStats& GetPonderStats() const;
+
+  const UctReport& GetReport() const;
+
  private:
-  int32_t count_round_;
+  mutable Uct<StateGame> uct_;
 };
 
+#include "uct-inl.hpp"
+
 #endif  // REVERSI_UCT_H__